@@ -104,24 +104,36 @@ public:
             parents[i].Genotype = initializer(rndlocal);
             parents[i][idx] = Operon::Numeric::Max<Operon::Scalar>();
         };
-        const auto& evaluator = generator.Evaluator();
-
-        auto evaluate = [&](Individual& ind) {
-            auto f = evaluator(random, ind);
-            if (!std::isfinite(f)) {
-                f = Operon::Numeric::Max<Operon::Scalar>();
+        auto& evaluator = generator.Evaluator();
+
+        // evaluate a batch of individuals at once (allowing the evaluator to share work between them), or only score
+        // individuals evaluated before again, without optimizing them or spending the budget (see EvaluatorBase::Rescore)
+        std::vector<Operon::Scalar> fitness(indices.size());
+        auto evaluate = [&](gsl::span<Individual> individuals, bool rescore) {
+            auto values = gsl::span<Operon::Scalar>(fitness).subspan(0, individuals.size());
+            if (rescore) {
+                evaluator.Rescore(random, individuals, values);
+            } else {
+                evaluator.EvaluateBatch(random, individuals, values);
+            }
+            for (size_t i = 0; i < individuals.size(); ++i) {
+                individuals[i][idx] = values[i];
             }
-            ind[idx] = f;
         };
 
         // generate the initial population and perform evaluation
         tbb::global_control c(tbb::global_control::max_allowed_parallelism, threads ? threads : std::thread::hardware_concurrency());
 
         std::for_each(std::execution::par_unseq, indices.begin(), indices.begin() + config.PopulationSize, create);
-        std::for_each(std::execution::par_unseq, parents.begin(), parents.end(), evaluate);
+        if (config.Generations > 0) {
+            evaluator.Resample(random, 0);
+        }
+        evaluate(parents, false);
 
         // flag to signal algorithm termination
         std::atomic_bool terminate = false;
+        // flags the offspring slots filled in the current generation
+        std::vector<uint8_t> generated(indices.size());
         // produce some offspring
         auto iterate = [&](size_t i) {
             Operon::RandomGenerator rndlocal { seeds[i] };
@@ -129,6 +141,7 @@ public:
             while (!(terminate = generator.Terminate())) {
                 if (auto result = generator(rndlocal, config.CrossoverProbability, config.MutationProbability); result.has_value()) {
                     offspring[i] = std::move(result.value());
+                    generated[i] = 1;
                     return;
                 }
             }
@@ -141,16 +154,41 @@ public:
         for (generation = 1; generation <= config.Generations; ++generation) {
             // get some new seeds
             std::generate(seeds.begin(), seeds.end(), [&]() { return random(); });
+            // when scoring on a sample of the training rows, the parents are re-scored on the sample of this generation
+            // so that they compete with the offspring on equal terms
+            if (bool sampled = !evaluator.Sample().empty(); evaluator.Resample(random, generation) || sampled) {
+                evaluate(parents, true);
+            }
             // preserve one elite
             auto best = std::min_element(parents.begin(), parents.end(), [&](const auto& lhs, const auto& rhs) { return lhs[idx] < rhs[idx]; });
             offspring[0] = *best;
 
             generator.Prepare(parents);
+            std::fill(generated.begin(), generated.end(), 0);
             // we always allow one elite (maybe this should be more configurable?)
             std::for_each(std::execution::par_unseq, indices.cbegin() + 1, indices.cbegin() + config.PoolSize, iterate);
+            if (generator.DeferredEvaluation()) {
+                // when the generator terminates during the generation, the slots it did not fill still hold (already
+                // scored) individuals of the previous reinsertion: move the new offspring in front and evaluate only them
+                size_t n = 1;
+                for (size_t i = 1; i < config.PoolSize; ++i) {
+                    if (!generated[i]) { continue; }
+                    if (i != n) { std::swap(offspring[n], offspring[i]); }
+                    ++n;
+                }
+                if (n > 1) {
+                    evaluate(gsl::span<Individual>(offspring).subspan(1, n - 1), false);
+                }
+            }
             // merge pool back into pop
             reinserter(random, parents, offspring);
 
+            // the final population is scored on the whole training range
+            if ((terminate || generation == config.Generations) && !evaluator.Sample().empty()) {
+                evaluator.ClearSample();
+                evaluate(parents, true);
+            }
+
             // report progress and stats
             if (report) {
                 std::invoke(report);
@@ -1,144 +1,72 @@
+/* This file is part of:
+ * Operon - Large Scale Genetic Programming Framework
+ *
+ * Licensed under the ISC License <https://opensource.org/licenses/ISC>
+ * Copyright (C) 2020 Bogdan Burlacu
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+ * REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+ * INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+ * LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+ * OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+ * PERFORMANCE OF THIS SOFTWARE.
+ */
+
 #ifndef CODEGEN_HPP
 #define CODEGEN_HPP
 
-#include <llvm/IR/CallingConv.h>
-#include <llvm/IR/Function.h>
-#include <llvm/IR/IRBuilder.h>
-#include <llvm/IR/IRPrintingPasses.h>
-#include <llvm/IR/LLVMContext.h>
-#include <llvm/IR/LegacyPassManager.h>
-#include <llvm/IR/Module.h>
-#include <llvm/IR/Verifier.h>
-#include <llvm/Pass.h>
-#include <llvm/Support/FormattedStream.h>
+#include <memory>
 
-#include <cmath>
-#include <core/tree.hpp>
+#include "core/dataset.hpp"
+#include "core/range.hpp"
+#include "core/tree.hpp"
+#include "gsl/gsl"
 
 namespace Operon {
+// JIT compiler lowering trees to native loops over a range of rows (requires USE_LLVM_JIT)
+// - the LLVM dependency is confined to src/codegen/generator.cpp
+// - leaf coefficients and variable columns are passed as arguments to the compiled function, therefore
+//   a compiled function only depends on the tree structure and is cached by the tree hash value
+//   (computed in relaxed mode), so that elites and long-lived individuals are only compiled once
+// - the compiled functions are evicted in least recently used order when the cache is full
 class CodeGen {
 public:
-    CodeGen()  {
-        module = std::make_unique<llvm::Module>("codegen", context);
-    }
-
-    llvm::Function* createFunction(const std::string& name, int arity, llvm::Module* module) {
-        auto func = module->getFunction(name);
-
-        if (!func) {
-            auto returnType = llvm::Type::getDoubleTy(module->getContext());
-            std::vector<llvm::Type*> argTypes(arity, llvm::Type::getDoubleTy(module->getContext()));
-            auto functionType = llvm::FunctionType::get(returnType, argTypes, false);
-            func = llvm::Function::Create(functionType, llvm::Function::ExternalLinkage, name, module);
-        }
-        return func;
-    }
-
-    llvm::Function* CompileTree(const Operon::Tree& tree) {
-        // we need to insert functions in the module for the mathematical operations that are not intrinsic
-        auto tangent = createFunction("tan", 1, module.get()); 
-
-        // we have to set up our function:
-        // return type: a double value
-        // input args:
-        // - a double pointer representing our data
-        // - number of rows
-        // - number of columns
-        // - data row we are evaluating right now
-        std::vector<llvm::Type*> arguments;
-
-        arguments.push_back(llvm::Type::getDoublePtrTy(module->getContext())); // data (pointer to double)
-        arguments.push_back(llvm::Type::getInt32Ty(module->getContext())); // number of rows (int32)
-        arguments.push_back(llvm::Type::getInt32Ty(module->getContext())); // number of cols (int32)
-        arguments.push_back(llvm::Type::getInt32Ty(module->getContext())); // current row    (int32)
+    // compiled function signature:
+    // - coefficients (one per leaf, in canonical order)
+    // - data columns (one per leaf, in canonical order, nullptr for constants)
+    // - first row, number of rows
+    // - output buffer
+    using Function = void (*)(Operon::Scalar const*, Operon::Scalar const* const*, uint64_t, uint64_t, Operon::Scalar*);
 
-        auto fType = llvm::FunctionType::get(llvm::Type::getDoubleTy(module->getContext()), arguments, /* is var arg */ false);
+    static constexpr size_t DefaultCacheCapacity = 10'000;
 
-        auto expr = llvm::Function::Create(fType, llvm::GlobalValue::ExternalLinkage, "expression", module.get());
-        expr->setCallingConv(llvm::CallingConv::C);
+    explicit CodeGen(size_t capacity = DefaultCacheCapacity);
+    ~CodeGen();
 
-        auto bb = llvm::BasicBlock::Create(module->getContext(), "entry", expr);
-        llvm::IRBuilder<> builder(module->getContext());
-        builder.SetInsertPoint(bb);
+    CodeGen(CodeGen const&) = delete;
+    CodeGen& operator=(CodeGen const&) = delete;
 
-        // tree evaluation goes here
-        const auto& nodes = tree.Nodes();
-        std::vector<llvm::Value*> ops(nodes.size());
+    // process-wide instance used by Evaluate() when the JIT backend is enabled
+    static CodeGen& Instance();
 
-        for (size_t i = 0; i < nodes.size(); ++i) {
-            switch (auto const& s = nodes[i]; s.Type) {
-            case NodeType::Add: {
-                auto a = i - 1; // first child index
-                auto b = a - 1 - nodes[a].Length;
-                ops[i] = builder.CreateBinOp(llvm::Instruction::Add, ops[a], ops[b]);
-                break;
-            }
-            case NodeType::Sub: {
-                auto a = i - 1; // first child index
-                auto b = a - 1 - nodes[a].Length;
-                ops[i] = builder.CreateBinOp(llvm::Instruction::Sub, ops[a], ops[b]);
-                break;
-            }
-            case NodeType::Mul: {
-                auto a = i - 1; // first child index
-                auto b = a - 1 - nodes[a].Length;
-                ops[i] = builder.CreateBinOp(llvm::Instruction::Mul, ops[a], ops[b]);
-                break;
-            }
-            case NodeType::Div: {
-                auto a = i - 1; // first child index
-                auto b = a - 1 - nodes[a].Length;
-                ops[i] = builder.CreateBinOp(llvm::Instruction::FDiv, ops[a], ops[b]);
-                break;
-            }
-            case NodeType::Exp: {
-                auto a = i - 1; // first child index
-                ops[i] = builder.CreateUnaryIntrinsic(llvm::Intrinsic::exp, ops[a]);
-                break;
-            }
-            case NodeType::Log: {
-                auto a = i - 1; // first child index
-                ops[i] = builder.CreateUnaryIntrinsic(llvm::Intrinsic::log, ops[a]);
-                break;
-            }
-            case NodeType::Sin: {
-                auto a = i - 1; // first child index
-                ops[i] = builder.CreateUnaryIntrinsic(llvm::Intrinsic::sin, ops[a]);
-                break;
-            }
-            case NodeType::Cos: {
-                auto a = i - 1; // first child index
-                ops[i] = builder.CreateUnaryIntrinsic(llvm::Intrinsic::cos, ops[a]);
-                break;
-            }
-            case NodeType::Tan: {
-                auto a = i - 1; // first child index
-                llvm::SmallVector<llvm::Value*, 1> args { ops[a] };
-                ops[i] = builder.CreateCall(tangent, args);
-                break;
-            }
-            case NodeType::Variable: {
-                break;
-            }
-            case NodeType::Constant: {
-                ops[i] = llvm::ConstantFP::get(module->getContext(), llvm::APFloat(nodes[i].Value));
-                break;
-            }
-            default: {
-                break;
-            }
-            }
-        }
-    }
+    // same semantics as Evaluate(tree, dataset, range, result, parameters)
+    // returns false if the tree could not be compiled, in which case the result is left untouched
+    bool Evaluate(Tree const& tree, Dataset const& dataset, Range range, gsl::span<Operon::Scalar> result, Operon::Scalar const* parameters = nullptr);
 
-    void Evaluate(const Tree& tree)
-    {
-    }
+    size_t CacheSize() const;
+    size_t CacheCapacity() const;
+    size_t CacheHits() const;
+    size_t CacheMisses() const;
 
 private:
-    llvm::LLVMContext context;
-    std::unique_ptr<llvm::Module> module;
+    struct Impl;
+    std::unique_ptr<Impl> impl;
 };
-}
+} // namespace Operon
 
 #endif
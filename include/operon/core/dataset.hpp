@@ -24,11 +24,15 @@
 #include <Eigen/Dense>
 #include <exception>
 #include <gsl/util>
+#include <memory>
 #include <numeric>
 #include <vector>
 #include <optional>
+#include <stdexcept>
+#include <type_traits>
 
 #include "core/common.hpp"
+#include "core/interval.hpp"
 #include "stat/meanvariance.hpp"
 #include "core/range.hpp"
 
@@ -47,37 +51,86 @@ public:
     using Matrix = Eigen::Array<Operon::Scalar, Eigen::Dynamic, Eigen::Dynamic, Eigen::ColMajor>;
     using Map = Eigen::Map<Matrix const>;
 
+    // the values are stored in the precision of Operon::Scalar and can additionally be kept in the other precision
+    static constexpr Precision StoragePrecision = PrecisionOf<Operon::Scalar>;
+    using Converted = PrecisionType<StoragePrecision == Precision::Single ? Precision::Double : Precision::Single>;
+    using ConvertedMatrix = Eigen::Array<Converted, Eigen::Dynamic, Eigen::Dynamic, Eigen::ColMajor>;
+
 private:
+    // the members written while reading a file are declared before the map initialized from it
     std::vector<Variable> variables;
+    std::vector<uint32_t> lookup; // hash table from the variable hashes to their position in variables (see Find)
     Matrix values;
+    std::vector<Interval> bounds; // range of the values of each column
+    std::shared_ptr<void const> mapping; // memory mapping of a file in the binary format (see WriteBinary), shared by the copies of a view over it
+    size_t chunkSize = 0; // rows per chunk when streaming the dataset (see ChunkSize)
+    std::vector<Operon::Scalar const*> columns; // the values of each column of a column view, empty otherwise (the values are then in map)
+    std::shared_ptr<void const> owner; // keeps the buffers of a column view alive
     Map map;
+    ConvertedMatrix converted; // empty unless requested with AddPrecision
+
+    // recompute the converted copy (if any) of column i, or of all the columns
+    void UpdateConverted();
+    void UpdateConverted(Eigen::Index i);
+
+    // rebuild the lookup table after the variables changed
+    void UpdateLookup();
+    // the variable with the given hash, or nullptr, in constant time
+    Variable const* Find(Operon::Hash hashValue) const noexcept;
+
+    // recompute the bounds of column i, or of all the columns
+    void UpdateBounds();
+    void UpdateBounds(Eigen::Index i);
 
     Dataset();
 
     // check if we own the data or if we are a view over someone else's data
-    bool IsView() const noexcept { return values.data() != map.data(); }
+    bool IsView() const noexcept { return !columns.empty() || values.data() != map.data(); }
+
+    // the values of column i, wherever they are stored
+    using ColumnMap = Eigen::Map<Eigen::Array<Operon::Scalar, Eigen::Dynamic, 1> const>;
+    ColumnMap Column(Eigen::Index i) const noexcept { return { columns.empty() ? map.col(i).data() : columns[static_cast<size_t>(i)], map.rows() }; }
 
-    // read data from a csv file and return a map (view of the data)
+    // read data from a csv file, parsed in parallel, and return a map (view of the data)
     Map ReadCsv(std::string const& path, bool hasHeader);
 
+    // map a file in the binary format into memory and return a map (view of the mapped values)
+    Map ReadBinary(std::string const& path);
+
     // this method ensures the same ordering of variables in the variables vector
     // based on index, name, hash value
     void InitializeVariables(std::vector<std::string> const&);
 
 public:
+    // read a csv file or, if it starts with the magic number of the binary format (see WriteBinary), map the file into memory:
+    // the dataset is then a read-only view of the mapped values, which are loaded on demand by the operating system
     Dataset(const std::string& file, bool hasHeader = false);
 
     Dataset(Dataset const& rhs)
         : variables(rhs.variables)
+        , lookup(rhs.lookup)
         , values(rhs.values)
-        , map(rhs.map)
+        , bounds(rhs.bounds)
+        , mapping(rhs.mapping)
+        , chunkSize(rhs.chunkSize)
+        , columns(rhs.columns)
+        , owner(rhs.owner)
+        , map(rhs.IsView() ? rhs.map.data() : values.data(), rhs.map.rows(), rhs.map.cols())
+        , converted(rhs.converted)
     {
     }
 
     Dataset(Dataset&& rhs) noexcept
-        : variables(rhs.variables)
+        : variables(std::move(rhs.variables))
+        , lookup(std::move(rhs.lookup))
         , values(std::move(rhs.values))
+        , bounds(std::move(rhs.bounds))
+        , mapping(std::move(rhs.mapping))
+        , chunkSize(rhs.chunkSize)
+        , columns(std::move(rhs.columns))
+        , owner(std::move(rhs.owner))
         , map(std::move(rhs.map))
+        , converted(std::move(rhs.converted))
     {
     }
 
@@ -92,6 +145,8 @@ public:
             values.col(i) = m;
         }
         new (&map) Map(values.data(), values.rows(), values.cols()); // we use placement new (no allocation)
+        UpdateLookup();
+        UpdateBounds();
     }
 
     Dataset(std::vector<std::vector<Operon::Scalar>> const& vals);
@@ -102,6 +157,11 @@ public:
 
     Dataset(Matrix&& vals);
 
+    // a view over independent columns (eg. the columns of a data frame), each pointing to `rows` contiguous values. the
+    // values are neither copied nor owned: `keepAlive` (if any) is released with the last copy of the dataset. such a
+    // view has no matrix of values (see Values)
+    Dataset(std::vector<std::string> const& names, std::vector<Operon::Scalar const*> cols, size_t rows, std::shared_ptr<void const> keepAlive = nullptr);
+
     Dataset& operator=(Dataset rhs)
     {
         swap(rhs);
@@ -111,14 +171,40 @@ public:
     void swap(Dataset& rhs) noexcept
     {
         variables.swap(rhs.variables);
+        lookup.swap(rhs.lookup);
         values.swap(rhs.values);
+        converted.swap(rhs.converted);
+        bounds.swap(rhs.bounds);
+        mapping.swap(rhs.mapping);
+        std::swap(chunkSize, rhs.chunkSize);
+        columns.swap(rhs.columns);
+        owner.swap(rhs.owner);
+        Map tmp(map.data(), map.rows(), map.cols());
+        new (&map) Map(rhs.map.data(), rhs.map.rows(), rhs.map.cols());
+        new (&rhs.map) Map(tmp.data(), tmp.rows(), tmp.cols());
     }
 
+    // write the dataset in a binary columnar format that is mapped into memory instead of being parsed when read back
+    // (see Dataset(std::string const&, bool)): a header, the variables in column order (hash, bounds and name) and the
+    // values of each column in the layout of Matrix, aligned to 64 bytes. numbers are stored in native byte order and the
+    // values in the precision of Operon::Scalar, files written in another precision are rejected when read
+    void WriteBinary(std::string const& path) const;
+
+    // true if the file starts with the magic number of the binary format
+    static bool IsBinary(std::string const& path);
+
     size_t Rows() const { return (size_t)map.rows(); }
     size_t Cols() const { return (size_t)map.cols(); }
     std::pair<size_t, size_t> Dimensions() const { return { Rows(), Cols() }; }
 
-    Eigen::Ref<Matrix const> Values() const { return map; }
+    // the values as a matrix, which a view over independent columns does not have
+    Eigen::Ref<Matrix const> Values() const
+    {
+        if (!columns.empty()) {
+            throw std::runtime_error("The values of a column view are not stored in a matrix.\n");
+        }
+        return map;
+    }
 
     std::vector<std::string> VariableNames();
     void SetVariableNames(std::vector<std::string> const&);
@@ -127,6 +213,51 @@ public:
     gsl::span<const Operon::Scalar> GetValues(Operon::Hash hashValue) const noexcept;
     gsl::span<const Operon::Scalar> GetValues(int index) const noexcept;
     gsl::span<const Operon::Scalar> GetValues(Variable const& variable) const noexcept { return GetValues(variable.Hash); }
+    // the segment of a column for a window of rows
+    gsl::span<const Operon::Scalar> GetValues(Operon::Hash hashValue, Range range) const noexcept { return GetValues(hashValue).subspan(range.Start(), range.Size()); }
+
+    // a dataset mapped from a file (see WriteBinary) need not fit in memory: the operating system reads its pages when
+    // they are accessed and evicts them under memory pressure. the evaluation then streams over the rows in chunks of
+    // ChunkSize() rows (see ForEachChunk), prefetching the next chunk while evaluating the current one
+    // - mapped datasets default to chunks of DefaultChunkBytes, resident datasets are not streamed (chunk size zero)
+    static constexpr size_t DefaultChunkBytes = 1UL << 25;
+    size_t ChunkSize() const noexcept { return chunkSize; }
+    void SetChunkSize(size_t rows) noexcept { chunkSize = rows; }
+
+    // ask the operating system to read the rows of the range ahead (asynchronously), if the dataset is mapped from a file
+    void Prefetch(Range range) const noexcept;
+
+    // keep a copy of the values converted to the given precision (nothing to do for the storage precision), so that
+    // the models can be evaluated in that precision without converting each value they read. the copy is kept up to
+    // date by Shuffle, Normalize and Standardize
+    void AddPrecision(Precision precision);
+    bool HasPrecision(Precision precision) const noexcept { return precision == StoragePrecision || converted.size() == map.size(); }
+
+    // the values of a variable in the precision of T, which must be available (see AddPrecision), empty for an unknown variable
+    template <typename T>
+    gsl::span<const T> GetValues(Operon::Hash hashValue) const noexcept
+    {
+        static_assert(std::is_same_v<T, Operon::Scalar> || std::is_same_v<T, Converted>, "T must be float or double");
+        if constexpr (std::is_same_v<T, Operon::Scalar>) {
+            return GetValues(hashValue);
+        } else {
+            EXPECT(HasPrecision(PrecisionOf<T>));
+            auto const* variable = Find(hashValue);
+            if (variable == nullptr) {
+                return {};
+            }
+            auto idx = static_cast<Eigen::Index>(variable->Index);
+            return gsl::span<const T>(converted.col(idx).data(), static_cast<size_t>(converted.rows()));
+        }
+    }
+
+    template <typename T>
+    gsl::span<const T> GetValues(Variable const& variable) const noexcept { return GetValues<T>(variable.Hash); }
+
+    // the smallest and largest (finite) values of a variable, eg. to bound the output of a tree (see EvaluateInterval),
+    // kept up to date by Normalize and Standardize
+    Interval GetBounds(Operon::Hash hashValue) const noexcept;
+    Interval GetBounds(Variable const& variable) const noexcept { return GetBounds(variable.Hash); }
 
     const std::optional<Variable> GetVariable(const std::string& name) const noexcept;
     const std::optional<Variable> GetVariable(Operon::Hash hashValue) const noexcept;
@@ -140,6 +271,34 @@ public:
     // standardize column i using mean and stddev calculated over the specified range
     void Standardize(size_t i, Range range);
 };
+
+// call f(chunk) on the consecutive chunks of the range (see Dataset::ChunkSize, a single chunk if the dataset is not
+// streamed), prefetching the next chunk before processing the current one. f may return a bool, false stopping the
+// iteration, in which case ForEachChunk returns false
+template <typename F>
+bool ForEachChunk(Dataset const& dataset, Range range, F&& f)
+{
+    auto size = dataset.ChunkSize();
+    if (size == 0) {
+        size = std::max(range.Size(), size_t { 1 });
+    } else {
+        dataset.Prefetch({ range.Start(), std::min(range.Start() + size, range.End()) });
+    }
+    for (auto start = range.Start(); start < range.End(); start += size) {
+        Range chunk { start, std::min(start + size, range.End()) };
+        if (dataset.ChunkSize() != 0 && chunk.End() < range.End()) {
+            dataset.Prefetch({ chunk.End(), std::min(chunk.End() + size, range.End()) });
+        }
+        if constexpr (std::is_same_v<std::invoke_result_t<F&, Range>, bool>) {
+            if (!f(chunk)) {
+                return false;
+            }
+        } else {
+            f(chunk);
+        }
+    }
+    return true;
 }
+} // namespace Operon
 
 #endif
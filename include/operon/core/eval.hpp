@@ -21,11 +21,26 @@
 #define OPERON_EVAL
 
 #include "dataset.hpp"
+#include "eval_context.hpp"
 #include "eval_detail.hpp"
 #include "gsl/gsl"
 #include "tree.hpp"
 #include "pset.hpp"
 #include "range.hpp"
+#include "subtree_cache.hpp"
+#include "tape.hpp"
+#include "vectormath.hpp"
+
+#include <array>
+#include <type_traits>
+
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
+#include <tbb/task_arena.h>
+
+#if defined(USE_LLVM_JIT)
+#include "codegen/generator.hpp"
+#endif
 
 namespace Operon {
 // evaluate a tree and return a vector of values
@@ -37,164 +52,1018 @@ Operon::Vector<T> Evaluate(Tree const& tree, Dataset const& dataset, Range const
     return result;
 }
 
+template <typename T, size_t S, NodeType N>
+constexpr auto dispatch_op = detail::dispatch_op<T, S, N>;
+
+namespace detail {
+    // pass the values of a variable instruction over `numRows` rows starting at `row` to f, read from the dataset
+    // in the evaluation precision if available, otherwise converted from the storage precision
+    template <typename T, typename F>
+    void ReadVariable(Instruction const& instr, size_t const row, size_t const numRows, F&& f)
+    {
+        if constexpr (std::is_same_v<T, Dataset::Converted>) {
+            if (instr.ConvertedData != nullptr) {
+                f(Eigen::Map<const Eigen::Array<T, Eigen::Dynamic, 1, Eigen::ColMajor>>(instr.ConvertedData + row, numRows));
+                return;
+            }
+        }
+        f(Eigen::Map<const Eigen::Array<Operon::Scalar, Eigen::Dynamic, 1, Eigen::ColMajor>>(instr.Data + row, numRows).template cast<T>());
+    }
+
+    // same as ReadVariable for the (non-contiguous) rows given by `indices`: f receives a function returning the value of the k-th row
+    template <typename T, typename F>
+    void GatherVariable(Instruction const& instr, size_t const* indices, F&& f)
+    {
+        if constexpr (std::is_same_v<T, Dataset::Converted>) {
+            if (instr.ConvertedData != nullptr) {
+                f([&](size_t k) { return instr.ConvertedData[indices[k]]; });
+                return;
+            }
+        }
+        f([&](size_t k) { return static_cast<T>(instr.Data[indices[k]]); });
+    }
+
+    // the arithmetic operations of arity one (on array expressions) or two (on values or array expressions)
+    // (in the same order as dispatch_op, so that the fused kernels below give the same results as the generic path)
+    template <NodeType N, typename A>
+    auto Apply(A const& a)
+    {
+        if constexpr (N == NodeType::Sub) {
+            return -a;
+        } else if constexpr (N == NodeType::Div) {
+            return a.inverse();
+        } else {
+            return a;
+        }
+    }
+
+    template <NodeType N, typename A, typename B>
+    auto Apply(A const& a, B const& b)
+    {
+        if constexpr (N == NodeType::Add) {
+            return a + b;
+        } else if constexpr (N == NodeType::Sub) {
+            return a - b;
+        } else if constexpr (N == NodeType::Mul) {
+            return a * b;
+        } else {
+            return a / b;
+        }
+    }
+
+    // the unary functions of the interpreter, applied in place to column r (like in ExecuteTape, the vectorized kernels
+    // only process the first `numRows` values and the others are applied to the whole column)
+    template <typename T, NodeType N, typename Column>
+    void ApplyFunction(Column r, size_t const numRows) noexcept
+    {
+        auto const x = r.data();
+        if constexpr (N == NodeType::Sqrt) {
+            r = r.sqrt();
+        } else if constexpr (N == NodeType::Square) {
+            r = r.square();
+        } else if constexpr (std::is_floating_point_v<T>) {
+            if constexpr (N == NodeType::Log) {
+                VectorMath::Log(x, x, numRows);
+            } else if constexpr (N == NodeType::Exp) {
+                VectorMath::Exp(x, x, numRows);
+            } else if constexpr (N == NodeType::Sin) {
+                VectorMath::Sin(x, x, numRows);
+            } else if constexpr (N == NodeType::Cos) {
+                VectorMath::Cos(x, x, numRows);
+            } else if constexpr (N == NodeType::Tan) {
+                VectorMath::Tan(x, x, numRows);
+            } else if constexpr (N == NodeType::Cbrt) {
+                VectorMath::Cbrt(x, x, numRows);
+            }
+        } else if constexpr (N == NodeType::Log) {
+            r = r.log();
+        } else if constexpr (N == NodeType::Exp) {
+            r = r.exp();
+        } else if constexpr (N == NodeType::Sin) {
+            r = r.sin();
+        } else if constexpr (N == NodeType::Cos) {
+            r = r.cos();
+        } else if constexpr (N == NodeType::Tan) {
+            r = r.tan();
+        } else if constexpr (N == NodeType::Cbrt) {
+            r = r.unaryExpr([](T v) { return T(ceres::cbrt(v)); });
+        }
+    }
+
+    // specialized kernels for the instructions with fused leaf arguments (see Tape): the arithmetic operations of
+    // arity at most two over any combination of scratch columns, weighted variables and constants, and the unary
+    // functions of a weighted variable. each combination of argument kinds is instantiated as a separate straight-line
+    // loop, in which the variables are read from the dataset and the constants are broadcast instead of being loaded
+    // from scratch columns
+    template <typename T, size_t S, NodeType N>
+    void ExecuteFused(Tape const& tape, Instruction const& instr, Operon::Vector<T> const& params, Eigen::Array<T, S, Eigen::Dynamic, Eigen::ColMajor>& m, size_t const row, size_t const numRows, size_t const* const indices) noexcept
+    {
+        constexpr bool arithmetic = N == NodeType::Add || N == NodeType::Sub || N == NodeType::Mul || N == NodeType::Div;
+        auto const instructions = tape.Instructions();
+        auto const args = tape.Arguments(instr);
+        auto r = m.col(instr.Result);
+        auto const fused = [&](size_t k) { return (instr.FusedArguments & (1u << k)) != 0; };
+
+        if (indices != nullptr) {
+            // f receives a function returning the value of the k-th argument for the i-th row
+            auto gather = [&](size_t k, auto&& f) {
+                if (!fused(k)) {
+                    auto c = m.col(args[k]);
+                    f([&](size_t i) { return c(static_cast<Eigen::Index>(i)); });
+                    return;
+                }
+                auto const w = params[args[k]];
+                if (instructions[args[k]].Opcode == NodeType::Constant) {
+                    f([&](size_t) { return w; });
+                    return;
+                }
+                GatherVariable<T>(instructions[args[k]], indices, [&](auto&& value) { f([&](size_t i) { return w * value(i); }); });
+            };
+            gather(0, [&](auto&& a) {
+                if (args.size() == 1) {
+                    for (size_t i = 0; i < numRows; ++i) {
+                        r(static_cast<Eigen::Index>(i)) = a(i);
+                    }
+                    if constexpr (arithmetic) {
+                        auto res = r.segment(0, numRows);
+                        res = Apply<N>(res);
+                    }
+                    return;
+                }
+                gather(1, [&](auto&& b) {
+                    for (size_t i = 0; i < numRows; ++i) {
+                        r(static_cast<Eigen::Index>(i)) = Apply<N>(a(i), b(i));
+                    }
+                });
+            });
+            if constexpr (!arithmetic) {
+                ApplyFunction<T, N>(r, numRows);
+            }
+            return;
+        }
+
+        // f receives an expression for the values of the k-th argument
+        auto read = [&](size_t k, auto&& f) {
+            if (!fused(k)) {
+                f(m.col(args[k]).segment(0, numRows));
+                return;
+            }
+            auto const w = params[args[k]];
+            if (instructions[args[k]].Opcode == NodeType::Constant) {
+                f(Eigen::Array<T, Eigen::Dynamic, 1>::Constant(static_cast<Eigen::Index>(numRows), w));
+                return;
+            }
+            ReadVariable<T>(instructions[args[k]], row, numRows, [&](auto const& seg) { f(w * seg); });
+        };
+        auto res = r.segment(0, numRows);
+        read(0, [&](auto const& a) {
+            if (args.size() == 1) {
+                if constexpr (arithmetic) {
+                    res = Apply<N>(a);
+                } else {
+                    res = a;
+                }
+                return;
+            }
+            if constexpr (arithmetic) {
+                read(1, [&](auto const& b) { res = Apply<N>(a, b); });
+            }
+        });
+        if constexpr (!arithmetic) {
+            ApplyFunction<T, N>(r, numRows);
+        }
+    }
+
+    // run all the tape instructions over a batch of `numRows` dataset rows starting at `row`, or over the rows
+    // indices[0], ..., indices[numRows - 1] if `indices` is not null
+    // (the transcendental functions of floating point batches use the vectorized kernels from core/vectormath.hpp)
+    template <typename T, size_t S>
+    void ExecuteTape(Tape const& tape, Operon::Vector<T> const& params, Eigen::Array<T, S, Eigen::Dynamic, Eigen::ColMajor>& m, size_t const row, size_t const numRows, size_t const* const indices = nullptr) noexcept
+    {
+        auto const instructions = tape.Instructions();
+
+        for (size_t i = 0; i < instructions.size(); ++i) {
+            auto const& instr = instructions[i];
+            if (instr.Fused) {
+                continue;
+            }
+            if (instr.FusedArguments != 0) {
+                switch (instr.Opcode) {
+                case NodeType::Add: {
+                    ExecuteFused<T, S, NodeType::Add>(tape, instr, params, m, row, numRows, indices);
+                    break;
+                }
+                case NodeType::Sub: {
+                    ExecuteFused<T, S, NodeType::Sub>(tape, instr, params, m, row, numRows, indices);
+                    break;
+                }
+                case NodeType::Mul: {
+                    ExecuteFused<T, S, NodeType::Mul>(tape, instr, params, m, row, numRows, indices);
+                    break;
+                }
+                case NodeType::Div: {
+                    ExecuteFused<T, S, NodeType::Div>(tape, instr, params, m, row, numRows, indices);
+                    break;
+                }
+                case NodeType::Log: {
+                    ExecuteFused<T, S, NodeType::Log>(tape, instr, params, m, row, numRows, indices);
+                    break;
+                }
+                case NodeType::Exp: {
+                    ExecuteFused<T, S, NodeType::Exp>(tape, instr, params, m, row, numRows, indices);
+                    break;
+                }
+                case NodeType::Sin: {
+                    ExecuteFused<T, S, NodeType::Sin>(tape, instr, params, m, row, numRows, indices);
+                    break;
+                }
+                case NodeType::Cos: {
+                    ExecuteFused<T, S, NodeType::Cos>(tape, instr, params, m, row, numRows, indices);
+                    break;
+                }
+                case NodeType::Tan: {
+                    ExecuteFused<T, S, NodeType::Tan>(tape, instr, params, m, row, numRows, indices);
+                    break;
+                }
+                case NodeType::Sqrt: {
+                    ExecuteFused<T, S, NodeType::Sqrt>(tape, instr, params, m, row, numRows, indices);
+                    break;
+                }
+                case NodeType::Cbrt: {
+                    ExecuteFused<T, S, NodeType::Cbrt>(tape, instr, params, m, row, numRows, indices);
+                    break;
+                }
+                case NodeType::Square: {
+                    ExecuteFused<T, S, NodeType::Square>(tape, instr, params, m, row, numRows, indices);
+                    break;
+                }
+                default: {
+                    break;
+                }
+                }
+                continue;
+            }
+            auto r = m.col(instr.Result);
+            auto const args = tape.Arguments(instr);
+
+            switch (instr.Opcode) {
+            case NodeType::Constant: {
+                // the column might have been reused by a parent node in the previous batch
+                r.setConstant(params[i]);
+                break;
+            }
+            case NodeType::Variable: {
+                if (indices != nullptr) {
+                    GatherVariable<T>(instr, indices, [&](auto&& value) {
+                        for (size_t k = 0; k < numRows; ++k) {
+                            r(static_cast<Eigen::Index>(k)) = params[i] * value(k);
+                        }
+                    });
+                    break;
+                }
+                ReadVariable<T>(instr, row, numRows, [&](auto const& seg) { r.segment(0, numRows) = params[i] * seg; });
+                break;
+            }
+            case NodeType::Add: {
+                dispatch_op<T, S, NodeType::Add>(m, instr.Result, args);
+                break;
+            }
+            case NodeType::Sub: {
+                dispatch_op<T, S, NodeType::Sub>(m, instr.Result, args);
+                break;
+            }
+            case NodeType::Mul: {
+                dispatch_op<T, S, NodeType::Mul>(m, instr.Result, args);
+                break;
+            }
+            case NodeType::Div: {
+                dispatch_op<T, S, NodeType::Div>(m, instr.Result, args);
+                break;
+            }
+            case NodeType::Log: {
+                if constexpr (std::is_floating_point_v<T>) {
+                    VectorMath::Log(m.col(args[0]).data(), r.data(), numRows);
+                } else {
+                    r = m.col(args[0]).log();
+                }
+                break;
+            }
+            case NodeType::Exp: {
+                if constexpr (std::is_floating_point_v<T>) {
+                    VectorMath::Exp(m.col(args[0]).data(), r.data(), numRows);
+                } else {
+                    r = m.col(args[0]).exp();
+                }
+                break;
+            }
+            case NodeType::Sin: {
+                if constexpr (std::is_floating_point_v<T>) {
+                    VectorMath::Sin(m.col(args[0]).data(), r.data(), numRows);
+                } else {
+                    r = m.col(args[0]).sin();
+                }
+                break;
+            }
+            case NodeType::Cos: {
+                if constexpr (std::is_floating_point_v<T>) {
+                    VectorMath::Cos(m.col(args[0]).data(), r.data(), numRows);
+                } else {
+                    r = m.col(args[0]).cos();
+                }
+                break;
+            }
+            case NodeType::Tan: {
+                if constexpr (std::is_floating_point_v<T>) {
+                    VectorMath::Tan(m.col(args[0]).data(), r.data(), numRows);
+                } else {
+                    r = m.col(args[0]).tan();
+                }
+                break;
+            }
+            case NodeType::Sqrt: {
+                r = m.col(args[0]).sqrt();
+                break;
+            }
+            case NodeType::Cbrt: {
+                if constexpr (std::is_floating_point_v<T>) {
+                    VectorMath::Cbrt(m.col(args[0]).data(), r.data(), numRows);
+                } else {
+                    r = m.col(args[0]).unaryExpr([](T v) { return T(ceres::cbrt(v)); });
+                }
+                break;
+            }
+            case NodeType::Square: {
+                r = m.col(args[0]).square();
+                break;
+            }
+            default: {
+                break;
+            }
+            }
+        }
+    }
+
+    // copy the root column into the result, replacing non-finite values
+    template <typename T, typename Column, typename Result>
+    void WriteResult(Column const& seg, Result&& res) noexcept
+    {
+        auto max_ = Operon::Numeric::Max<T>();
+#if EIGEN_MINOR_VERSION > 7
+        res = (seg.isFinite()).select(seg, max_);
+#else
+        // less efficient
+        res = seg.unaryExpr([&](auto v) { return ceres::IsFinite(v) ? v : max_; });
+#endif
+    }
+} // namespace detail
+
+// evaluate a compiled tape over the given range, writing the output values into the result span
+// (the scratch buffers are taken from the evaluation context, by default the one of the calling thread)
+template <typename T, size_t S = 512 / sizeof(T)>
+void Evaluate(Tape const& tape, Range const range, gsl::span<T> result, T const* const parameters = nullptr, EvaluationContext<T, S>& context = EvaluationContext<T, S>::Default()) noexcept
+{
+    EXPECT(tape.Length() > 0);
+    auto& m = context.Primal(tape.Columns());
+    Eigen::Map<Eigen::Array<T, Eigen::Dynamic, 1, Eigen::ColMajor>> res(result.data(), result.size(), 1);
+
+    auto const& params = context.Parameters(tape, parameters);
+    auto lastCol = m.col(tape.Root());
+
+    size_t numRows = range.Size();
+    for (size_t row = 0; row < numRows; row += S) {
+        auto remainingRows = std::min(S, numRows - row);
+        detail::ExecuteTape<T, S>(tape, params, m, range.Start() + row, remainingRows);
+        // the final result is found in the last section of the buffer corresponding to the root node
+        detail::WriteResult<T>(lastCol.segment(0, remainingRows), res.segment(row, remainingRows));
+    }
+}
+
+// rows per task of EvaluateParallel: the output values of a chunk (128kb in double precision) stay in the L2 cache
+constexpr size_t ParallelChunkSize = 16384;
+
+// ranges of at least this many rows are evaluated in parallel by the batched Evaluate overload, when its caller allows it
+constexpr size_t ParallelEvaluationThreshold = 1'000'000;
+
+// evaluate a compiled tape over a (large) range by splitting it into chunks of (at most) `chunkSize` rows that are
+// distributed over the TBB worker threads (work stealing), each chunk using the evaluation context of its thread
+// - whether the caller runs inside a parallel loop (eg. over the population) is not detected: it is up to the caller to
+//   evaluate serially there, since the outer loop already keeps all the threads busy
+// - the parallel loop is isolated, so that a thread waiting for the chunks of this call does not pick up unrelated outer
+//   tasks, which could reuse its thread-local evaluation context
+template <typename T, size_t S = 512 / sizeof(T)>
+void EvaluateParallel(Tape const& tape, Range const range, gsl::span<T> result, T const* const parameters = nullptr, size_t const chunkSize = ParallelChunkSize)
+{
+    EXPECT(result.size() == range.Size());
+    if (range.Size() <= chunkSize) {
+        Evaluate<T, S>(tape, range, result, parameters);
+        return;
+    }
+    tbb::this_task_arena::isolate([&]() {
+        tbb::parallel_for(tbb::blocked_range<size_t>(range.Start(), range.End(), chunkSize), [&](auto const& chunk) {
+            auto offset = chunk.begin() - range.Start();
+            Evaluate<T, S>(tape, Range { chunk.begin(), chunk.end() }, result.subspan(offset, chunk.size()), parameters);
+        });
+    });
+}
+
+// evaluate a tree over the range in chunks of `batchSize` rows. with `parallel` set, ranges of at least ParallelEvaluationThreshold
+// rows are evaluated in parallel (see EvaluateParallel): the caller sets it when it does not run inside a parallel loop itself
+// (eg. when scoring the final model)
 template <typename T>
-Operon::Vector<T> Evaluate(Tree const& tree, Dataset const& dataset, Range const range, size_t const batchSize, T const* const parameters = nullptr)
+Operon::Vector<T> Evaluate(Tree const& tree, Dataset const& dataset, Range const range, size_t const batchSize, T const* const parameters = nullptr, bool parallel = false)
 {
-    Operon::Vector<Operon::Scalar> result(range.Size());
-    gsl::span<Operon::Scalar> view(result);
+    Operon::Vector<T> result(range.Size());
+    gsl::span<T> view(result);
 
-    size_t n = range.Size() / batchSize;
-    size_t m = range.Size() % batchSize;
-    std::vector<size_t> indices(n + (m != 0));
-    std::iota(indices.begin(), indices.end(), 0ul);
-    std::for_each(indices.begin(), indices.end(), [&](auto idx)
-    {
-        auto start = range.Start() + idx * batchSize;
-        auto end = std::min(start + batchSize, range.End());
-        auto subview = view.subspan(idx * batchSize, end-start);
-        Evaluate<Operon::Scalar>(tree, dataset, Range{ start, end }, subview, parameters);
+    Tape tape(tree, dataset);
+
+    if (parallel && range.Size() >= ParallelEvaluationThreshold) {
+        EvaluateParallel<T>(tape, range, view, parameters, std::max(batchSize, ParallelChunkSize));
+        return result;
+    }
+    ForEachChunk(dataset, range, [&](Range chunk) {
+        for (size_t start = chunk.Start(); start < chunk.End(); start += batchSize) {
+            auto end = std::min(start + batchSize, chunk.End());
+            Evaluate<T>(tape, Range { start, end }, view.subspan(start - range.Start(), end - start), parameters);
+        }
     });
     return result;
 }
 
-template <typename T, size_t S, NodeType N>
-constexpr auto dispatch_op = detail::dispatch_op<T, S, N>;
+// evaluate a compiled tape over the given range without storing the output values: each batch of (at most S) values is
+// clamped like in Evaluate and passed to `consume(values, offset)` while it is still in cache, where offset is the position
+// of the batch relative to range.Start(). batches are consumed in row order
+// - `consume` may return a bool, false stopping the evaluation (the remaining batches are skipped)
+// - returns false if the evaluation was stopped by `consume`
+template <typename T, size_t S = 512 / sizeof(T), typename F>
+bool EvaluateAndReduce(Tape const& tape, Range const range, F&& consume, T const* const parameters = nullptr, EvaluationContext<T, S>& context = EvaluationContext<T, S>::Default())
+{
+    EXPECT(tape.Length() > 0);
+    auto& m = context.Primal(tape.Columns());
+    auto const& params = context.Parameters(tape, parameters);
+    auto lastCol = m.col(tape.Root());
+
+    size_t numRows = range.Size();
+    for (size_t row = 0; row < numRows; row += S) {
+        auto remainingRows = std::min(S, numRows - row);
+        detail::ExecuteTape<T, S>(tape, params, m, range.Start() + row, remainingRows);
+        // the root column is recomputed for every batch, so it can be clamped in place
+        auto seg = lastCol.segment(0, remainingRows);
+        detail::WriteResult<T>(seg, seg);
+        if constexpr (std::is_same_v<std::invoke_result_t<F&, gsl::span<T const>, size_t>, bool>) {
+            if (!consume(gsl::span<T const>(lastCol.data(), remainingRows), row)) {
+                return false;
+            }
+        } else {
+            consume(gsl::span<T const>(lastCol.data(), remainingRows), row);
+        }
+    }
+    return true;
+}
 
+// evaluate a compiled tape over the dataset rows given by `rows` (eg. a random sample of the training rows), writing the
+// value of row rows[i] into result[i]. the variable values are gathered batch by batch, so the rows should be sorted
+// for a cache-friendly access pattern
 template <typename T, size_t S = 512 / sizeof(T)>
-void Evaluate(Tree const& tree, Dataset const& dataset, Range const range, gsl::span<T> result, T const* const parameters = nullptr) noexcept
+void Evaluate(Tape const& tape, gsl::span<size_t const> rows, gsl::span<T> result, T const* const parameters = nullptr, EvaluationContext<T, S>& context = EvaluationContext<T, S>::Default()) noexcept
 {
-    const auto& nodes = tree.Nodes();
-    EXPECT(nodes.size() > 0);
-    Eigen::Array<T, S, Eigen::Dynamic, Eigen::ColMajor> m(S, nodes.size());
+    EXPECT(tape.Length() > 0);
+    EXPECT(result.size() == rows.size());
+    auto& m = context.Primal(tape.Columns());
     Eigen::Map<Eigen::Array<T, Eigen::Dynamic, 1, Eigen::ColMajor>> res(result.data(), result.size(), 1);
 
-    Operon::Vector<T> params(nodes.size());
-    Operon::Vector<gsl::span<const Operon::Scalar>> vals(nodes.size());
-    size_t idx = 0;
+    auto const& params = context.Parameters(tape, parameters);
+    auto lastCol = m.col(tape.Root());
 
-    bool treeContainsNonlinearSymbols = false;
-    for (size_t i = 0; i < nodes.size(); ++i) {
-        if (nodes[i].IsConstant()) {
-            auto v = parameters ? parameters[idx] : T(nodes[i].Value);
-            m.col(i).setConstant(v);
-            idx++;
-        } else if (nodes[i].IsVariable()) {
-            params[i] = parameters ? parameters[idx] : T(nodes[i].Value);
-            vals[i] = dataset.GetValues(nodes[i].HashValue);
-            idx++;
-        }
-        treeContainsNonlinearSymbols |= static_cast<bool>(nodes[i].Type & ~PrimitiveSet::Arithmetic);
+    size_t numRows = rows.size();
+    for (size_t row = 0; row < numRows; row += S) {
+        auto remainingRows = std::min(S, numRows - row);
+        detail::ExecuteTape<T, S>(tape, params, m, 0, remainingRows, rows.data() + row);
+        detail::WriteResult<T>(lastCol.segment(0, remainingRows), res.segment(row, remainingRows));
     }
+}
+
+template <typename T, size_t S = 512 / sizeof(T)>
+void Evaluate(Tree const& tree, Dataset const& dataset, gsl::span<size_t const> rows, gsl::span<T> result, T const* const parameters = nullptr, EvaluationContext<T, S>& context = EvaluationContext<T, S>::Default()) noexcept
+{
+    Evaluate<T, S>(context.Compile(tree, dataset), rows, result, parameters, context);
+}
 
-    auto lastCol = m.col(nodes.size() - 1);
+// same as EvaluateAndReduce over a range, for the dataset rows given by `rows` (the offset passed to `consume` is the
+// position of the batch in `rows`)
+template <typename T, size_t S = 512 / sizeof(T), typename F>
+bool EvaluateAndReduce(Tape const& tape, gsl::span<size_t const> rows, F&& consume, T const* const parameters = nullptr, EvaluationContext<T, S>& context = EvaluationContext<T, S>::Default())
+{
+    EXPECT(tape.Length() > 0);
+    auto& m = context.Primal(tape.Columns());
+    auto const& params = context.Parameters(tape, parameters);
+    auto lastCol = m.col(tape.Root());
 
-    size_t numRows = range.Size();
+    size_t numRows = rows.size();
     for (size_t row = 0; row < numRows; row += S) {
         auto remainingRows = std::min(S, numRows - row);
+        detail::ExecuteTape<T, S>(tape, params, m, 0, remainingRows, rows.data() + row);
+        auto seg = lastCol.segment(0, remainingRows);
+        detail::WriteResult<T>(seg, seg);
+        if constexpr (std::is_same_v<std::invoke_result_t<F&, gsl::span<T const>, size_t>, bool>) {
+            if (!consume(gsl::span<T const>(lastCol.data(), remainingRows), row)) {
+                return false;
+            }
+        } else {
+            consume(gsl::span<T const>(lastCol.data(), remainingRows), row);
+        }
+    }
+    return true;
+}
 
-        for (size_t i = 0; i < nodes.size(); ++i) {
-            typename decltype(m)::ColXpr r = m.col(i);
-            auto const& s = nodes[i];
+namespace detail {
+    // the jacobian over the `numRows` rows starting at `start` or, if `indices` is not null, the rows indices[0], ..., indices[numRows - 1]
+    template <typename T, int StorageOrder, size_t S>
+    void EvaluateJacobian(Tape const& tape, size_t const start, size_t const numRows, size_t const* const indices, gsl::span<T> result, gsl::span<T> jacobian, T const* const parameters, EvaluationContext<T, S>& context) noexcept
+    {
+        EXPECT(tape.Length() > 0);
+        EXPECT(tape.Columns() == tape.Length());
+        EXPECT(jacobian.size() >= numRows * tape.Coefficients());
+
+        auto const instructions = tape.Instructions();
+        auto const n = static_cast<Eigen::Index>(numRows);
+        auto const p = static_cast<Eigen::Index>(tape.Coefficients());
+
+        auto& m = context.Primal(tape.Columns()); // primal values
+        auto& a = context.Adjoint(tape.Columns()); // adjoints
+        Eigen::Map<Eigen::Array<T, Eigen::Dynamic, 1, Eigen::ColMajor>> res(result.data(), result.size(), 1);
+        Eigen::Map<Eigen::Array<T, Eigen::Dynamic, Eigen::Dynamic, StorageOrder>> jac(jacobian.data(), n, p);
+
+        auto const& params = context.Parameters(tape, parameters);
+
+        for (size_t row = 0; row < numRows; row += S) {
+            auto remainingRows = std::min(S, numRows - row);
+            ExecuteTape<T, S>(tape, params, m, start + row, remainingRows, indices == nullptr ? nullptr : indices + row);
+            WriteResult<T>(m.col(tape.Root()).segment(0, remainingRows), res.segment(row, remainingRows));
+
+            // each node has exactly one parent, so the adjoint of a child is simply assigned when visiting its parent
+            a.col(tape.Root()).setOnes();
 
-            if (GSL_LIKELY(s.IsLeaf())) {
-                if (s.IsVariable()) {
-                    Eigen::Map<const Eigen::Array<Operon::Scalar, Eigen::Dynamic, 1, Eigen::ColMajor>> seg(vals[i].data() + range.Start() + row, remainingRows);
-                    r.segment(0, remainingRows) = params[i] * seg.cast<T>();
+            for (size_t i = instructions.size(); i-- > 0;) {
+                auto const& instr = instructions[i];
+                auto const args = tape.Arguments(instr);
+                auto const g = a.col(instr.Result);
+                auto const v = m.col(instr.Result);
+
+                switch (instr.Opcode) {
+                case NodeType::Constant: {
+                    jac.col(static_cast<Eigen::Index>(instr.Coefficient)).segment(row, remainingRows) = g.segment(0, remainingRows);
+                    break;
+                }
+                case NodeType::Variable: {
+                    auto col = jac.col(static_cast<Eigen::Index>(instr.Coefficient));
+                    if (indices != nullptr) {
+                        GatherVariable<T>(instr, indices + row, [&](auto&& value) {
+                            for (size_t k = 0; k < remainingRows; ++k) {
+                                auto j = static_cast<Eigen::Index>(k);
+                                col(static_cast<Eigen::Index>(row) + j) = g(j) * value(k);
+                            }
+                        });
+                        break;
+                    }
+                    ReadVariable<T>(instr, start + row, remainingRows, [&](auto const& seg) {
+                        col.segment(row, remainingRows) = g.segment(0, remainingRows) * seg;
+                    });
+                    break;
                 }
-            } else {
-                switch (s.Type) {
                 case NodeType::Add: {
-                    dispatch_op<T, S, NodeType::Add>(m, nodes, i);
+                    for (auto c : args) {
+                        a.col(c) = g;
+                    }
                     break;
                 }
                 case NodeType::Sub: {
-                    dispatch_op<T, S, NodeType::Sub>(m, nodes, i);
+                    if (args.size() == 1) {
+                        a.col(args[0]) = -g;
+                        break;
+                    }
+                    a.col(args[0]) = g;
+                    for (size_t k = 1; k < args.size(); ++k) {
+                        a.col(args[k]) = -g;
+                    }
                     break;
                 }
                 case NodeType::Mul: {
-                    dispatch_op<T, S, NodeType::Mul>(m, nodes, i);
+                    // the derivative with respect to one factor is the product of the other factors
+                    for (size_t k = 0; k < args.size(); ++k) {
+                        auto d = a.col(args[k]);
+                        d = g;
+                        for (size_t l = 0; l < args.size(); ++l) {
+                            if (l != k) {
+                                d *= m.col(args[l]);
+                            }
+                        }
+                    }
                     break;
                 }
                 case NodeType::Div: {
-                    dispatch_op<T, S, NodeType::Div>(m, nodes, i);
+                    if (args.size() == 1) {
+                        a.col(args[0]) = -g * v.square();
+                        break;
+                    }
+                    auto d = a.col(args[0]);
+                    d = m.col(args[1]);
+                    for (size_t k = 2; k < args.size(); ++k) {
+                        d *= m.col(args[k]);
+                    }
+                    d = g / d;
+                    for (size_t k = 1; k < args.size(); ++k) {
+                        a.col(args[k]) = -g * v / m.col(args[k]);
+                    }
+                    break;
+                }
+                case NodeType::Log: {
+                    a.col(args[0]) = g / m.col(args[0]);
+                    break;
+                }
+                case NodeType::Exp: {
+                    a.col(args[0]) = g * v;
+                    break;
+                }
+                case NodeType::Sin: {
+                    a.col(args[0]) = g * m.col(args[0]).cos();
+                    break;
+                }
+                case NodeType::Cos: {
+                    a.col(args[0]) = -g * m.col(args[0]).sin();
+                    break;
+                }
+                case NodeType::Tan: {
+                    a.col(args[0]) = g * (T(1) + v.square());
+                    break;
+                }
+                case NodeType::Sqrt: {
+                    a.col(args[0]) = g / (T(2) * v);
+                    break;
+                }
+                case NodeType::Cbrt: {
+                    a.col(args[0]) = g / (T(3) * v.square());
+                    break;
+                }
+                case NodeType::Square: {
+                    a.col(args[0]) = T(2) * g * m.col(args[0]);
                     break;
                 }
                 default: {
-                    if (treeContainsNonlinearSymbols) {
-                        switch (s.Type) {
-                        case NodeType::Log: {
-                            r = m.col(i - 1).log();
-                            break;
-                        }
-                        case NodeType::Exp: {
-                            r = m.col(i - 1).exp();
-                            break;
-                        }
-                        case NodeType::Sin: {
-                            r = m.col(i - 1).sin();
-                            break;
-                        }
-                        case NodeType::Cos: {
-                            r = m.col(i - 1).cos();
-                            break;
-                        }
-                        case NodeType::Tan: {
-                            r = m.col(i - 1).tan();
-                            break;
-                        }
-                        case NodeType::Sqrt: {
-                            r = m.col(i - 1).sqrt();
-                            break;
-                        }
-                        case NodeType::Cbrt: {
-                            r = m.col(i - 1).unaryExpr([](T v) { return T(ceres::cbrt(v)); });
-                            break;
-                        }
-                        case NodeType::Square: {
-                            r = m.col(i - 1).square();
-                            break;
-                        }
-                        default: {
-                            break;
-                        }
-                        }
-                    }
                     break;
                 }
                 }
             }
         }
-        // the final result is found in the last section of the buffer corresponding to the root node
-        auto seg = lastCol.segment(0, remainingRows);
-        auto max_ = Operon::Numeric::Max<T>();
-#if EIGEN_MINOR_VERSION > 7
-        res.segment(row, remainingRows) = (seg.isFinite()).select(seg, max_);
-#else
-        // less efficient
-        res.segment(row, remainingRows) = seg.unaryExpr([&](auto v) { return ceres::IsFinite(v) ? v : max_; });
+    }
+} // namespace detail
+
+// reverse-mode (adjoint) differentiation with respect to the leaf coefficients
+// - computes the values and the full jacobian (range.Size() x tape.Coefficients(), in the given storage order)
+//   with one forward and one backward sweep over the tape, independently of the number of coefficients
+// - the backward sweep needs all the intermediate values, so the tape must be compiled with one column per node (reuseColumns = false)
+// - partial derivatives follow the n-ary semantics of the interpreter: a - (b + c + ...), a / (b * c * ...), -a and 1 / a for arity one
+template <typename T, int StorageOrder = Eigen::ColMajor, size_t S = 512 / sizeof(T)>
+void EvaluateJacobian(Tape const& tape, Range const range, gsl::span<T> result, gsl::span<T> jacobian, T const* const parameters = nullptr, EvaluationContext<T, S>& context = EvaluationContext<T, S>::Default()) noexcept
+{
+    detail::EvaluateJacobian<T, StorageOrder, S>(tape, range.Start(), range.Size(), nullptr, result, jacobian, parameters, context);
+}
+
+// same as above for the dataset rows given by `rows` (the i-th row of the jacobian corresponds to rows[i])
+template <typename T, int StorageOrder = Eigen::ColMajor, size_t S = 512 / sizeof(T)>
+void EvaluateJacobian(Tape const& tape, gsl::span<size_t const> rows, gsl::span<T> result, gsl::span<T> jacobian, T const* const parameters = nullptr, EvaluationContext<T, S>& context = EvaluationContext<T, S>::Default()) noexcept
+{
+    detail::EvaluateJacobian<T, StorageOrder, S>(tape, 0, rows.size(), rows.data(), result, jacobian, parameters, context);
+}
+
+template <typename T, size_t S = 512 / sizeof(T)>
+void Evaluate(Tree const& tree, Dataset const& dataset, Range const range, gsl::span<T> result, T const* const parameters = nullptr, EvaluationContext<T, S>& context = EvaluationContext<T, S>::Default()) noexcept
+{
+#if defined(USE_LLVM_JIT)
+    // the JIT backend handles plain scalar evaluation, falling back to the tape if the tree cannot be compiled
+    if constexpr (std::is_same_v<T, Operon::Scalar>) {
+        if (CodeGen::Instance().Evaluate(tree, dataset, range, result, parameters)) {
+            return;
+        }
+    }
 #endif
+    // a streamed dataset is evaluated chunk by chunk (see ForEachChunk)
+    auto const& tape = context.Compile(tree, dataset);
+    ForEachChunk(dataset, range, [&](Range chunk) {
+        Evaluate<T, S>(tape, chunk, result.subspan(chunk.Start() - range.Start(), chunk.Size()), parameters, context);
+    });
+}
+
+// evaluate a tree, reusing the values of subtrees found in the cache and inserting the values of newly evaluated subtrees
+// - node hash values must be computed in strict mode beforehand (tree.Hash<F>(Operon::HashMode::Strict))
+// - the largest cached subtrees are looked up first (from the root downwards) and read from the cache instead of being evaluated
+// - evaluated subtrees of at least cache.MinLength() nodes are inserted into the cache (with their raw, unclamped values)
+// - the cache is only used for plain scalar evaluation with the tree coefficients (no parameter array)
+template <size_t S = 512 / sizeof(Operon::Scalar)>
+void Evaluate(Tree const& tree, Dataset const& dataset, Range const range, gsl::span<Operon::Scalar> result, SubtreeCache& cache, EvaluationContext<Operon::Scalar, S>& context = EvaluationContext<Operon::Scalar, S>::Default())
+{
+    using T = Operon::Scalar;
+
+    auto const& nodes = tree.Nodes();
+    EXPECT(nodes.size() > 0);
+
+    Eigen::Map<Eigen::Array<T, Eigen::Dynamic, 1, Eigen::ColMajor>> res(result.data(), result.size(), 1);
+    auto const numRows = range.Size();
+
+    std::vector<SubtreeCache::Column> cached(nodes.size());
+    std::vector<T const*> substitutions(nodes.size(), nullptr);
+    std::vector<bool> skip(nodes.size(), false);
+
+    for (size_t i = nodes.size(); i-- > 0;) {
+        auto const& node = nodes[i];
+        if (node.IsLeaf() || node.Length + 1ul < cache.MinLength()) {
+            continue;
+        }
+        if (auto column = cache.Get(dataset, range, node.CalculatedHashValue)) {
+            // tape data pointers are indexed by dataset row
+            substitutions[i] = column->data() - range.Start();
+            cached[i] = std::move(column);
+            std::fill_n(skip.begin() + static_cast<std::ptrdiff_t>(i - node.Length), node.Length, true);
+            i -= node.Length;
+        }
+    }
+
+    if (cached.back()) {
+        Eigen::Map<const Eigen::Array<T, Eigen::Dynamic, 1, Eigen::ColMajor>> values(cached.back()->data(), numRows);
+        detail::WriteResult<T>(values, res.segment(0, numRows));
+        return;
+    }
+
+    // one column per instruction, so that the values of all the evaluated subtrees are available after each batch
+    auto const& tape = context.Compile(tree, dataset, /* reuseColumns */ false, substitutions);
+
+    // (node index, instruction index, values) of the subtrees to be inserted into the cache
+    std::vector<std::tuple<size_t, size_t, std::shared_ptr<Operon::Vector<T>>>> inserted;
+    for (size_t i = 0, k = 0; i < nodes.size(); ++i) {
+        if (skip[i]) {
+            continue;
+        }
+        auto const& node = nodes[i];
+        if (!node.IsLeaf() && !cached[i] && node.Length + 1ul >= cache.MinLength()) {
+            inserted.emplace_back(i, k, std::make_shared<Operon::Vector<T>>(numRows));
+        }
+        ++k;
+    }
+
+    auto& m = context.Primal(tape.Columns());
+    auto const& params = context.Parameters(tape, nullptr);
+    auto lastCol = m.col(tape.Root());
+
+    for (size_t row = 0; row < numRows; row += S) {
+        auto remainingRows = std::min(S, numRows - row);
+        detail::ExecuteTape<T, S>(tape, params, m, range.Start() + row, remainingRows);
+        detail::WriteResult<T>(lastCol.segment(0, remainingRows), res.segment(row, remainingRows));
+
+        for (auto& [i, k, values] : inserted) {
+            std::copy_n(m.col(static_cast<Eigen::Index>(k)).data(), remainingRows, values->data() + row);
+        }
+    }
+
+    for (auto& [i, k, values] : inserted) {
+        cache.Put(dataset, range, nodes[i].CalculatedHashValue, std::move(values));
+    }
+}
+
+// values of all the nodes of a tree over a range of rows (see EvaluateIncremental below)
+struct EvaluationTrace {
+    using Column = std::shared_ptr<Operon::Vector<Operon::Scalar> const>;
+
+    Tree Genotype; // the evaluated tree, used to find the nodes changed by mutation
+    Dataset const* Data = nullptr;
+    Range Rows;
+    std::vector<Column> Columns; // raw (unclamped) values, one column per node
+};
+
+// evaluate a tree incrementally with respect to the trace of a previously evaluated tree (usually the parent of a point-mutated offspring)
+// - if both trees have the same shape, only the changed nodes and their ancestors (following the Node::Parent links) are evaluated,
+//   their unchanged children are read from the previous trace. the cost is then proportional to the depth of the changed nodes instead of the tree length
+// - otherwise (different shape, dataset or range, or no previous trace) the whole tree is evaluated
+// - returns the trace of the evaluated tree, which shares the columns of the unchanged nodes with the previous trace
+template <size_t S = 512 / sizeof(Operon::Scalar)>
+std::shared_ptr<EvaluationTrace const> EvaluateIncremental(Tree const& tree, Dataset const& dataset, Range const range, gsl::span<Operon::Scalar> result, std::shared_ptr<EvaluationTrace const> const& previous = nullptr, EvaluationContext<Operon::Scalar, S>& context = EvaluationContext<Operon::Scalar, S>::Default())
+{
+    using T = Operon::Scalar;
+
+    auto const& nodes = tree.Nodes();
+    EXPECT(nodes.size() > 0);
+
+    Eigen::Map<Eigen::Array<T, Eigen::Dynamic, 1, Eigen::ColMajor>> res(result.data(), result.size(), 1);
+    auto const numRows = range.Size();
+
+    auto compatible = previous != nullptr
+        && previous->Data == &dataset
+        && previous->Rows.Bounds() == range.Bounds()
+        && previous->Genotype.Length() == nodes.size();
+
+    auto const& previousNodes = compatible ? previous->Genotype.Nodes() : nodes;
+    for (size_t i = 0; compatible && i < nodes.size(); ++i) {
+        compatible = nodes[i].Arity == previousNodes[i].Arity && nodes[i].Length == previousNodes[i].Length;
+    }
+
+    std::vector<bool> dirty(nodes.size(), !compatible);
+    if (compatible) {
+        for (size_t i = 0; i < nodes.size(); ++i) {
+            auto const& a = nodes[i];
+            auto const& b = previousNodes[i];
+            if (dirty[i] || (a.Type == b.Type && a.HashValue == b.HashValue && a.Value == b.Value)) {
+                continue;
+            }
+            // mark the changed node and its ancestors
+            for (auto j = i; !dirty[j]; j = nodes[j].Parent) {
+                dirty[j] = true;
+                if (j == nodes.size() - 1) {
+                    break;
+                }
+            }
+        }
+
+        if (!dirty.back()) {
+            Eigen::Map<const Eigen::Array<T, Eigen::Dynamic, 1, Eigen::ColMajor>> values(previous->Columns.back()->data(), numRows);
+            detail::WriteResult<T>(values, res.segment(0, numRows));
+            return previous;
+        }
+    }
+
+    auto trace = std::make_shared<EvaluationTrace>();
+    trace->Genotype = tree;
+    trace->Data = &dataset;
+    trace->Rows = range;
+    trace->Columns.resize(nodes.size());
+
+    // unchanged children of changed nodes are read from the previous trace, the rest of their subtrees are not evaluated
+    std::vector<T const*> substitutions(nodes.size(), nullptr);
+    std::vector<std::pair<size_t, std::shared_ptr<Operon::Vector<T>>>> evaluated; // (instruction index, values)
+    for (size_t i = 0, k = 0; i < nodes.size(); ++i) {
+        if (!dirty[i]) {
+            trace->Columns[i] = previous->Columns[i];
+            if (dirty[nodes[i].Parent]) {
+                substitutions[i] = previous->Columns[i]->data() - range.Start();
+                ++k;
+            }
+            continue;
+        }
+        auto values = std::make_shared<Operon::Vector<T>>(numRows);
+        trace->Columns[i] = values;
+        evaluated.emplace_back(k++, std::move(values));
+    }
+
+    auto const& tape = context.Compile(tree, dataset, /* reuseColumns */ false, compatible ? gsl::span<T const* const>(substitutions) : gsl::span<T const* const>{});
+
+    auto& m = context.Primal(tape.Columns());
+    auto const& params = context.Parameters(tape, nullptr);
+    auto lastCol = m.col(tape.Root());
+
+    for (size_t row = 0; row < numRows; row += S) {
+        auto remainingRows = std::min(S, numRows - row);
+        detail::ExecuteTape<T, S>(tape, params, m, range.Start() + row, remainingRows);
+        detail::WriteResult<T>(lastCol.segment(0, remainingRows), res.segment(row, remainingRows));
+
+        for (auto& [k, values] : evaluated) {
+            std::copy_n(m.col(static_cast<Eigen::Index>(k)).data(), remainingRows, values->data() + row);
+        }
+    }
+    return trace;
+}
+
+// batch sizes (rows per batch, the S parameter of the evaluation functions) that can be selected at runtime, from 256 to 2048
+// bytes per scratch column. the default S = 512 / sizeof(T) is the second one
+template <typename T>
+constexpr std::array<size_t, 4> BatchSizes { 256 / sizeof(T), 512 / sizeof(T), 1024 / sizeof(T), 2048 / sizeof(T) };
+
+// size in bytes of the L1 data cache (detected once, 32kb if unknown)
+size_t DataCacheSize() noexcept;
+
+// the largest of BatchSizes such that the scratch buffer of a tape with the given number of columns (see Tape::Columns) fills at
+// most half of the L1 data cache, the other half being left to the input values of the batch: short trees are evaluated in long
+// batches with less loop overhead per row, long trees in short batches whose scratch buffer stays in cache
+template <typename T>
+size_t AutomaticBatchSize(size_t columns) noexcept
+{
+    auto const budget = DataCacheSize() / 2;
+    for (auto it = BatchSizes<T>.rbegin(); it != BatchSizes<T>.rend(); ++it) {
+        if (*it * std::max(columns, size_t { 1 }) * sizeof(T) <= budget) {
+            return *it;
+        }
+    }
+    return BatchSizes<T>.front();
+}
+
+// call f(std::integral_constant<size_t, S>{}) with S the largest of BatchSizes not above `batchSize` (the smallest one if none is),
+// or S = AutomaticBatchSize(columns) if `batchSize` is zero. the evaluation functions are instantiated for each of these sizes
+template <typename T, typename F>
+decltype(auto) WithBatchSize(size_t batchSize, size_t columns, F&& f)
+{
+    constexpr auto sizes = BatchSizes<T>;
+    if (batchSize == 0) {
+        batchSize = AutomaticBatchSize<T>(columns);
+    }
+    if (batchSize >= sizes[3]) {
+        return f(std::integral_constant<size_t, sizes[3]> {});
+    }
+    if (batchSize >= sizes[2]) {
+        return f(std::integral_constant<size_t, sizes[2]> {});
+    }
+    if (batchSize >= sizes[1]) {
+        return f(std::integral_constant<size_t, sizes[1]> {});
+    }
+    return f(std::integral_constant<size_t, sizes[0]> {});
+}
+
+// number of rows processed by all the trees in a group before moving on to the next tile
+constexpr size_t DefaultTileSize = 1024;
+
+// evaluate a group of trees over the given range, using tiles of rows in the outer loop and trees in the inner loop,
+// so that each tile of the input columns is loaded once and then reused (from cache) by all the trees in the group
+// - results are stored contiguously: the values of the i-th tree are found at [i * range.Size(), (i+1) * range.Size())
+// - the evaluation is sequential, callers can evaluate distinct groups of trees in parallel
+
+template <typename T, size_t S = 512 / sizeof(T)>
+void EvaluatePopulation(gsl::span<Tape const> tapes, Range const range, gsl::span<T> results, size_t const tileSize = DefaultTileSize, EvaluationContext<T, S>& context = EvaluationContext<T, S>::Default()) noexcept
+{
+    EXPECT(results.size() >= tapes.size() * range.Size());
+    EXPECT(tileSize > 0);
+
+    size_t numRows = range.Size();
+    for (size_t row = 0; row < numRows; row += tileSize) {
+        auto remainingRows = std::min(tileSize, numRows - row);
+        Range tile { range.Start() + row, range.Start() + row + remainingRows };
+
+        for (size_t i = 0; i < tapes.size(); ++i) {
+            Evaluate<T, S>(tapes[i], tile, results.subspan(i * numRows + row, remainingRows), nullptr, context);
+        }
+    }
+}
+
+// same as above but the output values are not stored, each batch of values of the i-th tree is passed to
+// `consume(i, values, offset)` instead (see EvaluateAndReduce). the batches of each tree are consumed in row order
+template <typename T, size_t S = 512 / sizeof(T), typename F>
+void EvaluatePopulationAndReduce(gsl::span<Tape const> tapes, Range const range, F&& consume, size_t const tileSize = DefaultTileSize, EvaluationContext<T, S>& context = EvaluationContext<T, S>::Default())
+{
+    EXPECT(tileSize > 0);
+
+    size_t numRows = range.Size();
+    for (size_t row = 0; row < numRows; row += tileSize) {
+        auto remainingRows = std::min(tileSize, numRows - row);
+        Range tile { range.Start() + row, range.Start() + row + remainingRows };
+
+        for (size_t i = 0; i < tapes.size(); ++i) {
+            EvaluateAndReduce<T, S>(tapes[i], tile, [&](gsl::span<T const> values, size_t offset) { consume(i, values, row + offset); }, nullptr, context);
+        }
+    }
+}
+
+// same as above for the dataset rows given by `rows`, the offsets passed to `consume` being positions in `rows`
+template <typename T, size_t S = 512 / sizeof(T), typename F>
+void EvaluatePopulationAndReduce(gsl::span<Tape const> tapes, gsl::span<size_t const> rows, F&& consume, size_t const tileSize = DefaultTileSize, EvaluationContext<T, S>& context = EvaluationContext<T, S>::Default())
+{
+    EXPECT(tileSize > 0);
+
+    size_t numRows = rows.size();
+    for (size_t row = 0; row < numRows; row += tileSize) {
+        auto tile = rows.subspan(row, std::min(tileSize, numRows - row));
+
+        for (size_t i = 0; i < tapes.size(); ++i) {
+            EvaluateAndReduce<T, S>(tapes[i], tile, [&](gsl::span<T const> values, size_t offset) { consume(i, values, row + offset); }, nullptr, context);
+        }
+    }
+}
+
+template <typename T, size_t S = 512 / sizeof(T)>
+void EvaluatePopulation(gsl::span<Tree const> trees, Dataset const& dataset, Range const range, gsl::span<T> results, size_t const tileSize = DefaultTileSize) noexcept
+{
+    std::vector<Tape> tapes;
+    tapes.reserve(trees.size());
+    for (auto const& tree : trees) {
+        tapes.emplace_back(tree, dataset);
     }
+    EvaluatePopulation<T, S>(gsl::span<Tape const>(tapes), range, results, tileSize);
 }
 
+// the tape is compiled once on construction and reused by all subsequent calls
+// (eg. by the local optimizer, which evaluates the same tree many times with different parameters)
 struct TreeEvaluator {
     TreeEvaluator(Tree const& tree, Dataset const& dataset, const Range range)
-        : tree_ref(tree)
-        , dataset_ref(dataset)
+        : tape(tree, dataset)
         , range(range)
     {
     }
 
+    // the scratch buffers come from the calling thread's context for the scalar type T (Operon::Scalar or Dual)
     template <typename T>
     bool operator()(T const* const* parameters, T* result) const
     {
         gsl::span<T> view(result, range.Size());
-        Evaluate(tree_ref, dataset_ref, range, view, parameters[0]);
+        Evaluate(tape, range, view, parameters[0], EvaluationContext<T>::Default());
         return true;
     }
 
 private:
-    std::reference_wrapper<const Tree> tree_ref;
-    std::reference_wrapper<const Dataset> dataset_ref;
+    Tape tape;
     Range range;
 };
 
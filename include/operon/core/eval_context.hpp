@@ -0,0 +1,108 @@
+/* This file is part of:
+ * Operon - Large Scale Genetic Programming Framework
+ *
+ * Licensed under the ISC License <https://opensource.org/licenses/ISC>
+ * Copyright (C) 2020 Bogdan Burlacu
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+ * REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+ * INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+ * LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+ * OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+ * PERFORMANCE OF THIS SOFTWARE.
+ */
+
+
+#ifndef OPERON_EVAL_CONTEXT_HPP
+#define OPERON_EVAL_CONTEXT_HPP
+
+#include <Eigen/Core>
+
+#include "core/common.hpp"
+#include "core/dataset.hpp"
+#include "core/tape.hpp"
+#include "core/tree.hpp"
+#include "gsl/gsl"
+
+namespace Operon {
+// reusable evaluation workspace: the scratch buffers, leaf parameters, tape and output values needed by the
+// evaluation routines are kept between calls and only grow (to the largest tree and range seen so far),
+// so that repeated evaluations do not allocate
+// - a context must only be used by one thread at a time, Default() returns a per-thread instance
+// - the buffers are indexed by scalar type and batch size (S rows per scratch column) through the template parameters
+template <typename T, size_t S = 512 / sizeof(T)>
+class EvaluationContext {
+public:
+    using Buffer = Eigen::Array<T, S, Eigen::Dynamic, Eigen::ColMajor>;
+
+    // scratch buffer with at least the given number of columns (the contents are not preserved when it grows)
+    Buffer& Primal(size_t columns)
+    {
+        return Reserve(primal, columns);
+    }
+
+    // second scratch buffer used by the reverse sweep of EvaluateJacobian
+    Buffer& Adjoint(size_t columns)
+    {
+        return Reserve(adjoint, columns);
+    }
+
+    // leaf values (constants or variable weights) indexed by instruction, taken from the parameter array if one is given
+    Operon::Vector<T> const& Parameters(Tape const& tape, T const* const parameters)
+    {
+        auto const instructions = tape.Instructions();
+        params.resize(instructions.size());
+        for (size_t i = 0; i < instructions.size(); ++i) {
+            auto const& instr = instructions[i];
+            if (instr.Opcode == NodeType::Constant || instr.Opcode == NodeType::Variable) {
+                params[i] = parameters ? parameters[instr.Coefficient] : T(instr.Value);
+            }
+        }
+        return params;
+    }
+
+    // compile the tree into the context's tape (valid until the next call)
+    Tape const& Compile(Tree const& tree, Dataset const& dataset, bool reuseColumns = true, gsl::span<Operon::Scalar const* const> substitutions = {})
+    {
+        tape.Compile(tree, dataset, reuseColumns, substitutions);
+        return tape;
+    }
+
+    // output buffer for callers that need one (eg. the evaluators), valid until the next call
+    gsl::span<T> Values(size_t size)
+    {
+        if (values.size() < size) {
+            values.resize(size);
+        }
+        return { values.data(), size };
+    }
+
+    static EvaluationContext& Default()
+    {
+        thread_local EvaluationContext context;
+        return context;
+    }
+
+private:
+    static Buffer& Reserve(Buffer& buffer, size_t columns)
+    {
+        if (static_cast<size_t>(buffer.cols()) < columns) {
+            buffer.resize(S, static_cast<Eigen::Index>(columns));
+        }
+        return buffer;
+    }
+
+    Buffer primal;
+    Buffer adjoint;
+    Operon::Vector<T> params;
+    Operon::Vector<T> values;
+    Tape tape;
+};
+} // namespace Operon
+
+#endif
@@ -21,6 +21,7 @@
 #define OPERON_EVAL_DETAIL
 
 #include "node.hpp"
+#include "gsl/span"
 #include <Eigen/Dense>
 
 namespace Operon {
@@ -91,44 +92,40 @@ namespace detail {
     // 1) improved performance: the naive method accumulates into the result for each argument, leading to unnecessary assignments
     // 2) minimizing the number of intermediate steps which might improve floating point accuracy of some operations
     //    if arity > 5, one accumulation is performed every 5 args
+    // the argument (child) column indices are resolved beforehand (see core/tape.hpp)
     template <typename T, size_t S, Operon::NodeType N>
-    inline void dispatch_op(Eigen::DenseBase<Eigen::Array<T, S, Eigen::Dynamic, Eigen::ColMajor>>& m, Operon::Vector<Node> const& nodes, size_t parentIndex)
+    inline void dispatch_op(Eigen::DenseBase<Eigen::Array<T, S, Eigen::Dynamic, Eigen::ColMajor>>& m, size_t resultIndex, gsl::span<const size_t> args)
     {
-        auto result = m.col(parentIndex);
+        auto result = m.col(resultIndex);
 
         using f = op<T, S, N>;
-        const auto g = [](bool cont, decltype(result) res, auto&&... args) { cont ? f::accumulate(res, args...) : f::apply(res, args...); };
-        const auto nextArg = [&](size_t i) { return i - (nodes[i].Length + 1); };
-
-        auto arg1 = parentIndex - 1;
+        const auto g = [](bool cont, decltype(result) res, auto&&... cols) { cont ? f::accumulate(res, cols...) : f::apply(res, cols...); };
 
+        size_t k = 0;
         bool continued = false;
 
-        int arity = nodes[parentIndex].Arity;
+        size_t arity = args.size();
         while (arity > 0) {
             switch (arity) {
             case 1: {
-                g(continued, result, m.col(arg1));
+                g(continued, result, m.col(args[k]));
                 arity = 0;
                 break;
             }
             case 2: {
-                auto arg2 = nextArg(arg1);
-                g(continued, result, m.col(arg1), m.col(arg2));
+                g(continued, result, m.col(args[k]), m.col(args[k + 1]));
                 arity = 0;
                 break;
             }
             case 3: {
-                auto arg2 = nextArg(arg1), arg3 = nextArg(arg2);
-                g(continued, result, m.col(arg1), m.col(arg2), m.col(arg3));
+                g(continued, result, m.col(args[k]), m.col(args[k + 1]), m.col(args[k + 2]));
                 arity = 0;
                 break;
             }
             default: {
-                auto arg2 = nextArg(arg1), arg3 = nextArg(arg2), arg4 = nextArg(arg3);
-                g(continued, result, m.col(arg1), m.col(arg2), m.col(arg3), m.col(arg4));
+                g(continued, result, m.col(args[k]), m.col(args[k + 1]), m.col(args[k + 2]), m.col(args[k + 3]));
                 arity -= 4;
-                arg1 = nextArg(arg4);
+                k += 4;
                 break;
             }
             }
@@ -137,36 +134,29 @@ namespace detail {
     }
 
     template <typename T, size_t S, Operon::NodeType N>
-    inline void dispatch_op_simple_binary(Eigen::DenseBase<Eigen::Array<T, S, Eigen::Dynamic, Eigen::ColMajor>>& m, Operon::Vector<Node> const& nodes, size_t parentIndex)
+    inline void dispatch_op_simple_binary(Eigen::DenseBase<Eigen::Array<T, S, Eigen::Dynamic, Eigen::ColMajor>>& m, size_t resultIndex, gsl::span<const size_t> args)
     {
-        auto r = m.col(parentIndex);
-        size_t i = parentIndex - 1;
-        size_t arity = nodes[parentIndex].Arity;
+        auto r = m.col(resultIndex);
 
-        if (arity == 1) {
-            op<T, S, N>::apply(r, m.col(i));
+        if (args.size() == 1) {
+            op<T, S, N>::apply(r, m.col(args[0]));
         } else {
-            auto j = i - (nodes[i].Length + 1);
-            op<T, S, N>::apply(r, m.col(i), m.col(j));
+            op<T, S, N>::apply(r, m.col(args[0]), m.col(args[1]));
         }
     }
 
     template <typename T, size_t S, Operon::NodeType N>
-    inline void dispatch_op_simple_nary(Eigen::DenseBase<Eigen::Array<T, S, Eigen::Dynamic, Eigen::ColMajor>>& m, Operon::Vector<Node> const& nodes, size_t parentIndex)
+    inline void dispatch_op_simple_nary(Eigen::DenseBase<Eigen::Array<T, S, Eigen::Dynamic, Eigen::ColMajor>>& m, size_t resultIndex, gsl::span<const size_t> args)
     {
-        auto r = m.col(parentIndex);
-        size_t arity = nodes[parentIndex].Arity;
-
-        auto i = parentIndex - 1;
+        auto r = m.col(resultIndex);
 
-        if (arity == 1) {
-            op<T, S, N>::apply(r, m.col(i));
+        if (args.size() == 1) {
+            op<T, S, N>::apply(r, m.col(args[0]));
         } else {
-            r = m.col(i);
+            r = m.col(args[0]);
 
-            for (size_t k = 1; k < arity; ++k) {
-                i -= nodes[i].Length + 1;
-                op<T, S, N>::accumulate(r, m.col(i));
+            for (size_t k = 1; k < args.size(); ++k) {
+                op<T, S, N>::accumulate(r, m.col(args[k]));
             }
         }
     }
@@ -2,15 +2,20 @@
 #define OPERON_INDIVIDUAL_HPP
 
 #include <cstddef>
+#include <memory>
 #include "core/tree.hpp"
 #include "core/types.hpp"
 #include <gsl/util>
 
 namespace Operon {
 
+struct EvaluationTrace; // see core/eval.hpp
+
 struct Individual {
     Tree Genotype;
     std::vector<Operon::Scalar> Fitness;
+    // per-node values from the last evaluation (only with incremental evaluation, see EvaluatorBase)
+    std::shared_ptr<EvaluationTrace const> Trace;
 
     Operon::Scalar& operator[](size_t i) noexcept { return Fitness[i]; }
     Operon::Scalar operator[](size_t i) const noexcept { return Fitness[i]; }
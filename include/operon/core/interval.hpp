@@ -0,0 +1,97 @@
+/* This file is part of:
+ * Operon - Large Scale Genetic Programming Framework
+ *
+ * Licensed under the ISC License <https://opensource.org/licenses/ISC>
+ * Copyright (C) 2020 Bogdan Burlacu
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+ * REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+ * INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+ * LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+ * OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+ * PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifndef OPERON_INTERVAL
+#define OPERON_INTERVAL
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "core/common.hpp"
+
+// interval arithmetic used to bound the output of a tree over the rows of a dataset without evaluating it
+// - an interval encloses all the values an expression can take when its variables range over their bounds
+//   (up to rounding: the bounds are computed in double precision with the default rounding mode)
+// - the enclosure is not tight, since the same variable is bounded independently at each occurrence (x - x gives [l - u, u - l])
+// - an undefined interval (nan bounds) means that some values may be nan, eg. the logarithm of an interval containing negative numbers
+namespace Operon {
+class Dataset;
+class Tree;
+
+struct Interval {
+    double Lower;
+    double Upper;
+
+    static constexpr Interval Point(double value) noexcept { return { value, value }; }
+    static constexpr Interval Unbounded() noexcept { return { -std::numeric_limits<double>::infinity(), std::numeric_limits<double>::infinity() }; }
+    static constexpr Interval Undefined() noexcept { return { std::numeric_limits<double>::quiet_NaN(), std::numeric_limits<double>::quiet_NaN() }; }
+
+    bool IsDefined() const noexcept { return !(std::isnan(Lower) || std::isnan(Upper)); }
+    // all the enclosed values are finite numbers
+    bool IsFinite() const noexcept { return std::isfinite(Lower) && std::isfinite(Upper); }
+    bool Contains(double value) const noexcept { return Lower <= value && value <= Upper; }
+    double Width() const noexcept { return Upper - Lower; }
+};
+
+inline Interval operator+(Interval a, Interval b) noexcept { return { a.Lower + b.Lower, a.Upper + b.Upper }; }
+inline Interval operator-(Interval a) noexcept { return { -a.Upper, -a.Lower }; }
+inline Interval operator-(Interval a, Interval b) noexcept { return { a.Lower - b.Upper, a.Upper - b.Lower }; }
+
+inline Interval operator*(Interval a, Interval b) noexcept
+{
+    if (!a.IsDefined() || !b.IsDefined()) {
+        return Interval::Undefined();
+    }
+    // 0 * inf is taken as 0: an unbounded factor is only reached in the limit
+    auto mul = [](double x, double y) { return x == 0 || y == 0 ? 0.0 : x * y; };
+    double p[] = { mul(a.Lower, b.Lower), mul(a.Lower, b.Upper), mul(a.Upper, b.Lower), mul(a.Upper, b.Upper) };
+    return { *std::min_element(std::begin(p), std::end(p)), *std::max_element(std::begin(p), std::end(p)) };
+}
+
+// 1 / a, unbounded if a contains zero
+inline Interval Inverse(Interval a) noexcept
+{
+    if (!a.IsDefined()) {
+        return a;
+    }
+    if (a.Contains(0)) {
+        return Interval::Unbounded();
+    }
+    return { 1 / a.Upper, 1 / a.Lower };
+}
+
+inline Interval operator/(Interval a, Interval b) noexcept { return a * Inverse(b); }
+
+Interval Exp(Interval a) noexcept;
+Interval Log(Interval a) noexcept;
+Interval Sin(Interval a) noexcept;
+Interval Cos(Interval a) noexcept;
+Interval Tan(Interval a) noexcept;
+Interval Sqrt(Interval a) noexcept;
+Interval Cbrt(Interval a) noexcept;
+Interval Square(Interval a) noexcept;
+
+// the interval enclosing the output of the tree when each variable ranges over the bounds of its dataset column
+// (see Dataset::GetBounds), following the semantics of the interpreter (n-ary nodes, weighted variables). the
+// coefficients are taken from the tree or, if not null, from `parameters` (in the order of Tree::GetCoefficients)
+Interval EvaluateInterval(Tree const& tree, Dataset const& dataset, Operon::Scalar const* parameters = nullptr);
+} // namespace Operon
+
+#endif
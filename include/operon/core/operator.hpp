@@ -22,6 +22,9 @@
 
 #include "gsl/gsl"
 #include <atomic>
+#include <execution>
+#include <functional>
+#include <numeric>
 #include <random>
 #include <type_traits>
 
@@ -29,7 +32,9 @@
 #include "dataset.hpp"
 #include "pset.hpp"
 #include "individual.hpp"
+#include "interval.hpp"
 #include "problem.hpp"
+#include "subtree_cache.hpp"
 #include "tree.hpp"
 
 namespace Operon {
@@ -122,6 +127,9 @@ public:
 
     using ReturnType = OperatorBase::ReturnType;
 
+    // fitness assigned by EvaluateBounded to the rejected individuals
+    static constexpr Operon::Scalar RejectedFitness = Operon::Numeric::Max<Operon::Scalar>();
+
     EvaluatorBase(Problem& p)
         : problem(p)
         , objIndex(0ul)
@@ -133,30 +141,155 @@ public:
         population = pop;
         objIndex = idx;
     }
+
+    // evaluate a batch of individuals and write their fitness values into the output span
+    // the default implementation calls operator() for each individual, derived evaluators can override
+    // it to share the evaluation work between the individuals (eg. using EvaluatePopulation)
+    virtual void EvaluateBatch(Operon::RandomGenerator& random, gsl::span<Individual> individuals, gsl::span<Operon::Scalar> fitness) const
+    {
+        EXPECT(individuals.size() == fitness.size());
+        std::vector<size_t> indices(individuals.size());
+        std::iota(indices.begin(), indices.end(), 0ul);
+        std::for_each(std::execution::par_unseq, indices.begin(), indices.end(), [&](size_t i) {
+            auto f = (*this)(random, individuals[i]);
+            fitness[i] = std::isfinite(f) ? f : Operon::Numeric::Max<Operon::Scalar>();
+        });
+    }
+
+    // score the individuals again as they are (eg. the parents on the sample of a new generation): unlike EvaluateBatch,
+    // the genotypes are neither simplified nor optimized and the scores are counted by RescoredEvaluations instead of
+    // against the budget. the default implementation calls operator() for each individual, the derived evaluators that
+    // modify the genotypes override it
+    virtual void Rescore(Operon::RandomGenerator& random, gsl::span<Individual> individuals, gsl::span<Operon::Scalar> fitness) const
+    {
+        rescoredEvaluations += individuals.size();
+        EvaluatorBase::EvaluateBatch(random, individuals, fitness);
+    }
+
+    // evaluate an individual that is only of interest if its fitness is below `bound` (eg. the offspring selection threshold):
+    // evaluators able to bound the final fitness from the rows evaluated so far may stop early and return RejectedFitness
+    // once the bound cannot be beaten. the default implementation evaluates the individual fully
+    virtual ReturnType EvaluateBounded(Operon::RandomGenerator& random, Individual& ind, Operon::Scalar /*bound*/) const
+    {
+        return (*this)(random, ind);
+    }
+
     size_t TotalEvaluations() const { return fitnessEvaluations + localEvaluations; }
     size_t FitnessEvaluations() const { return fitnessEvaluations; }
     size_t LocalEvaluations() const { return localEvaluations; }
+    // fitness evaluations stopped early by EvaluateBounded or the interval prescreening (also counted as fitness evaluations)
+    size_t RejectedEvaluations() const { return rejectedEvaluations; }
+    // scores of individuals evaluated before (see Rescore), not counted as fitness evaluations
+    size_t RescoredEvaluations() const { return rescoredEvaluations; }
 
     void SetLocalOptimizationIterations(size_t value) { iterations = value; }
     size_t GetLocalOptimizationIterations() const { return iterations; }
 
     void SetBudget(size_t value) { budget = value; }
     size_t GetBudget() const { return budget; }
+
+    // opt-in subtree cache shared by all evaluations (not owned by the evaluator, nullptr disables caching)
+    void SetSubtreeCache(SubtreeCache* value) { subtreeCache = value; }
+    SubtreeCache* GetSubtreeCache() const { return subtreeCache; }
+
+    // keep the per-node values of each evaluated individual, so that mutation-only offspring are re-evaluated
+    // incrementally from their parent's values (memory: tree length x training rows values per individual)
+    void SetIncrementalEvaluation(bool value) { incrementalEvaluation = value; }
+    bool GetIncrementalEvaluation() const { return incrementalEvaluation; }
+
+    // score the individuals on a random sample of the training rows instead of all of them, redrawn by
+    // Resample (eg. at each generation). the schedule gives the sample size for a generation, zero or a size of at
+    // least the number of training rows meaning all of them. the subtree cache and incremental evaluation
+    // are not used on a sample, and the coefficients are still optimized over all the training rows
+    void SetSampleSchedule(std::function<size_t(size_t)> value) { sampleSchedule = std::move(value); }
+    void SetSampleSize(size_t value) { sampleSchedule = [value](size_t) { return value; }; }
+    bool IsSampling() const { return static_cast<bool>(sampleSchedule); }
+
+    // draw the training rows for the given generation (the previous sample must no longer be in use),
+    // returns true if the individuals are now scored on a sample
+    bool Resample(Operon::RandomGenerator& random, size_t generation)
+    {
+        sample.clear();
+        auto range = problem.get().TrainingRange();
+        auto rows = problem.get().TrainingRows();
+        auto count = rows.empty() ? range.Size() : rows.size();
+        auto size = sampleSchedule ? sampleSchedule(generation) : 0;
+        if (size == 0 || size >= count) {
+            return false;
+        }
+        // selection sampling (Knuth's algorithm S), which yields the rows in increasing order
+        sample.reserve(size);
+        std::uniform_real_distribution<double> dist;
+        for (size_t i = 0; sample.size() < size; ++i) {
+            if (static_cast<double>(count - i) * dist(random) < static_cast<double>(size - sample.size())) {
+                sample.push_back(rows.empty() ? range.Start() + i : rows[i]);
+            }
+        }
+        return true;
+    }
+
+    // score the individuals on the whole training range again
+    void ClearSample() { sample.clear(); }
+
+    // the (sorted) sample of training rows, empty if not sampling
+    gsl::span<size_t const> Sample() const { return sample; }
+
+    // the (sorted) rows the individuals are scored on: the sample, otherwise the training rows of the problem (see
+    // Problem::TrainingRows), empty for the whole training range
+    gsl::span<size_t const> Rows() const { return sample.empty() ? problem.get().TrainingRows() : gsl::span<size_t const>(sample); }
+
+    // simplify each genotype in place (see Tree::Simplify) before it is optimized and scored
+    void SetSimplification(bool value) { simplification = value; }
+    bool GetSimplification() const { return simplification; }
+
+    // bound the output of each genotype with interval arithmetic over the ranges of the dataset columns (see EvaluateInterval)
+    // before it is optimized and scored, rejecting it (RejectedFitness) without touching the data if the bounds are not finite.
+    // the bounds are conservative: a rejected genotype may still have finite values on all the training rows (eg. log(x * x + 1))
+    void SetIntervalPrescreening(bool value) { intervalPrescreening = value; }
+    bool GetIntervalPrescreening() const { return intervalPrescreening; }
+
+    // number of rows evaluated together by the interpreter, rounded down to one of the precompiled batch sizes (see BatchSizes).
+    // zero (the default) selects the batch size of each tree, or group of trees, from its scratch buffer size and the L1 data cache
+    // size (see AutomaticBatchSize). the subtree cache and incremental evaluation always use the default batch size
+    void SetBatchSize(size_t value) { batchSize = value; }
+    size_t GetBatchSize() const { return batchSize; }
+
     bool BudgetExhausted() const { return TotalEvaluations() > GetBudget(); }
 
     void Reset()
     {
         fitnessEvaluations = 0;
         localEvaluations = 0;
+        rejectedEvaluations = 0;
+        rescoredEvaluations = 0;
     }
 
 protected:
+    // true if the genotype is rejected by the interval prescreening (if enabled), counting the rejection
+    bool Prescreen(Tree const& genotype) const
+    {
+        if (!intervalPrescreening || EvaluateInterval(genotype, problem.get().GetDataset()).IsFinite()) {
+            return false;
+        }
+        ++rejectedEvaluations;
+        return true;
+    }
+
     gsl::span<const Individual> population;
     std::reference_wrapper<const Problem> problem;
     mutable std::atomic_ulong fitnessEvaluations = 0;
     mutable std::atomic_ulong localEvaluations = 0;
+    mutable std::atomic_ulong rejectedEvaluations = 0;
+    mutable std::atomic_ulong rescoredEvaluations = 0;
     size_t iterations = DefaultLocalOptimizationIterations;
     size_t budget = DefaultEvaluationBudget;
+    SubtreeCache* subtreeCache = nullptr;
+    bool incrementalEvaluation = false;
+    bool simplification = false;
+    bool intervalPrescreening = false;
+    size_t batchSize = 0;
+    std::function<size_t(size_t)> sampleSchedule;
+    std::vector<size_t> sample;
     mutable size_t objIndex;
 };
 
@@ -184,8 +317,23 @@ public:
         this->MaleSelector().Prepare(pop);
     }
     virtual bool Terminate() const { return evaluator.get().BudgetExhausted(); }
+    // if true, the generated offspring are not evaluated by the generator and must be evaluated by the caller
+    // (for example all at once using EvaluatorBase::EvaluateBatch)
+    virtual bool DeferredEvaluation() const { return false; }
 
 protected:
+    // mutate the offspring of a crossover, or else a copy of the parent: a mutation-only offspring keeps the parent's
+    // trace, so that it can be re-evaluated incrementally from the parent's node values
+    void Mutate(Operon::RandomGenerator& random, Individual& child, Individual const& parent, bool crossedOver) const
+    {
+        if (crossedOver) {
+            child.Genotype = this->mutator(random, std::move(child.Genotype));
+            return;
+        }
+        child.Genotype = this->mutator(random, parent.Genotype);
+        child.Trace = parent.Trace;
+    }
+
     std::reference_wrapper<EvaluatorBase> evaluator;
     std::reference_wrapper<CrossoverBase> crossover;
     std::reference_wrapper<MutatorBase> mutator;
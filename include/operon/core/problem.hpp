@@ -20,6 +20,7 @@
 #ifndef PROBLEM_HPP
 #define PROBLEM_HPP
 
+#include <algorithm>
 #include <string>
 #include <vector>
 
@@ -66,6 +67,19 @@ public:
 
     Problem& TrainingRange(Range range) {
         training = range;
+        trainingRows.clear();
+        return *this;
+    }
+
+    // train on an arbitrary set of dataset rows (eg. the complement of a cross-validation fold or a bootstrap resample)
+    // instead of a contiguous range: the rows are sorted (duplicates are kept) so that their values are gathered in order,
+    // and the training range becomes the smallest range containing them
+    Problem& TrainingRows(std::vector<size_t> rows) {
+        EXPECT(!rows.empty());
+        std::sort(rows.begin(), rows.end());
+        EXPECT(rows.back() < dataset.Rows());
+        training = Range { rows.front(), rows.back() + 1 };
+        trainingRows = std::move(rows);
         return *this;
     }
 
@@ -105,6 +119,8 @@ public:
     }
 
     Range TrainingRange() const { return training; }
+    // the training rows, empty if the training set is the whole training range
+    gsl::span<const size_t> TrainingRows() const { return trainingRows; }
     Range TestRange() const { return test; }
     Range ValidationRange() const { return validation; }
 
@@ -114,6 +130,16 @@ public:
     const Dataset& GetDataset() const { return dataset; }
     Dataset& GetDataset() { return dataset; }
 
+    // the precision in which the evaluators compute the model outputs, by default the storage precision of the dataset
+    // (eg. evolve the models in single precision and re-score the final ones in double precision)
+    Problem& SetPrecision(Operon::Precision value) {
+        dataset.AddPrecision(value);
+        precision = value;
+        return *this;
+    }
+
+    Operon::Precision GetPrecision() const { return precision; }
+
     const gsl::span<const Variable> InputVariables() const { return inputVariables; }
     const gsl::span<const Operon::Scalar> TargetValues() { return dataset.GetValues(target.Hash); }
 
@@ -134,10 +160,12 @@ private:
     Dataset dataset;
     PrimitiveSet pset;
     Range training;
+    std::vector<size_t> trainingRows;
     Range test;
     Range validation;
     Variable target;
     std::vector<Variable> inputVariables;
+    Operon::Precision precision = Dataset::StoragePrecision;
 };
 }
 
@@ -0,0 +1,99 @@
+/* This file is part of:
+ * Operon - Large Scale Genetic Programming Framework
+ *
+ * Licensed under the ISC License <https://opensource.org/licenses/ISC>
+ * Copyright (C) 2020 Bogdan Burlacu
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+ * REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+ * INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+ * LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+ * OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+ * PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifndef OPERON_SUBTREE_CACHE_HPP
+#define OPERON_SUBTREE_CACHE_HPP
+
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+#include "core/common.hpp"
+#include "core/dataset.hpp"
+#include "core/range.hpp"
+
+namespace Operon {
+// bounded, thread-safe cache mapping subtree hash values to their evaluated output column
+// - keys are node hash values computed in strict mode (tree.Hash<F>(Operon::HashMode::Strict)), which
+//   depend on both the subtree structure and its coefficients
+// - all the columns cover the same range of the same dataset. the cache is bound to the dataset and range
+//   of the first request, and it is emptied whenever a request comes with a different dataset or range
+//   (eg. after Problem::TrainingRange was changed). if the dataset values are modified in place, Clear() must be called
+// - the capacity is a memory budget (in bytes) for the cached values, entries are evicted in least recently used order
+// - only subtrees with at least MinLength() nodes are worth caching (short subtrees are cheaper to re-evaluate)
+class SubtreeCache {
+public:
+    using Column = std::shared_ptr<Operon::Vector<Operon::Scalar> const>;
+
+    static constexpr size_t DefaultMinLength = 5;
+
+    explicit SubtreeCache(size_t capacityBytes, size_t minSubtreeLength = DefaultMinLength)
+        : capacity(capacityBytes)
+        , minLength(minSubtreeLength)
+    {
+    }
+
+    SubtreeCache(SubtreeCache const&) = delete;
+    SubtreeCache& operator=(SubtreeCache const&) = delete;
+
+    // returns the cached column for the given hash value or nullptr (the column remains valid after eviction)
+    Column Get(Dataset const& dataset, Range range, Operon::Hash hash);
+    // inserts a column, evicting the least recently used entries if the memory budget is exceeded
+    void Put(Dataset const& dataset, Range range, Operon::Hash hash, Column column);
+    void Clear();
+
+    size_t Size() const;
+    size_t MemoryUsage() const; // in bytes
+    size_t Capacity() const noexcept { return capacity; } // in bytes
+    size_t MinLength() const noexcept { return minLength; }
+
+    size_t Hits() const;
+    size_t Misses() const;
+    size_t Evictions() const;
+
+private:
+    struct Entry {
+        Column Values;
+        std::list<Operon::Hash>::iterator Position;
+    };
+
+    // empties the cache if the request refers to a different dataset or range (the caller holds the lock)
+    void Bind(Dataset const& dataset, Range range);
+    void Evict();
+
+    size_t capacity;
+    size_t minLength;
+
+    Dataset const* boundDataset = nullptr;
+    Range boundRange;
+
+    std::unordered_map<Operon::Hash, Entry> entries;
+    std::list<Operon::Hash> recent; // most recently used first
+    size_t memory = 0;
+
+    size_t hits = 0;
+    size_t misses = 0;
+    size_t evictions = 0;
+
+    mutable std::mutex mutex;
+};
+} // namespace Operon
+
+#endif
@@ -0,0 +1,95 @@
+/* This file is part of:
+ * Operon - Large Scale Genetic Programming Framework
+ *
+ * Licensed under the ISC License <https://opensource.org/licenses/ISC>
+ * Copyright (C) 2020 Bogdan Burlacu
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+ * REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+ * INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+ * LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+ * OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+ * PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifndef OPERON_TAPE_HPP
+#define OPERON_TAPE_HPP
+
+#include <vector>
+
+#include "core/common.hpp"
+#include "core/dataset.hpp"
+#include "core/tree.hpp"
+#include "gsl/gsl"
+
+namespace Operon {
+// a single tape entry, corresponding to one tree node (in postfix order)
+struct Instruction {
+    NodeType Opcode;
+    uint16_t Arity;
+    bool Fused; // leaf read directly by its parent instead of being written to its scratch column (see Tape)
+    uint8_t FusedArguments; // bit k is set if the k-th argument is a fused leaf (the argument is then the index of its instruction)
+    size_t Result; // scratch column receiving the output of this instruction
+    size_t Arguments; // offset of the first argument (scratch column index) in the tape's argument list
+    size_t Coefficient; // index into the parameter array (only meaningful for leaf nodes)
+    Operon::Scalar Value; // constant value or variable weight
+    Operon::Scalar const* Data; // pre-resolved data column (only for variable nodes)
+    Dataset::Converted const* ConvertedData; // the same column in the other precision, if the dataset provides it (see Dataset::AddPrecision)
+};
+
+// the tape is a flat representation of a tree where all the information needed
+// for evaluation (child column indices, variable data pointers) is resolved once
+// - it does not depend on the evaluation scalar type, so the same tape can be
+//   used with plain floating point values or with dual numbers (the Jet path)
+// - it holds raw pointers into the dataset and must not outlive it
+// - by default, scratch columns are reused once the value they hold has been consumed,
+//   which keeps the evaluation buffer small (and cache-resident) for long trees. if
+//   `reuseColumns` is false, each instruction writes into its own column (Result == instruction index)
+//   and all intermediate values remain available after evaluation
+// - when reusing columns, the leaves that are arguments of small nodes are fused into their parent: the variables and
+//   constants of the arithmetic operations of arity at most two and the variables of the unary functions. the parent
+//   is then executed by a kernel specialized for its argument kinds, which reads the weighted dataset values and
+//   broadcasts the constants directly, saving the store and load of a scratch column per leaf (the fused instructions
+//   are skipped by the interpreter)
+// - `substitutions` (optional, one entry per tree node) replaces the subtree rooted at a node with a precomputed
+//   column of values (eg. from a subtree cache): the node becomes a variable-like instruction with weight one reading
+//   from the given pointer (indexed by dataset row), and the nodes of its subtree are not emitted. such a tape
+//   must be evaluated without a parameter array
+class Tape {
+public:
+    Tape() = default;
+    Tape(Tree const& tree, Dataset const& dataset, bool reuseColumns = true, gsl::span<Operon::Scalar const* const> substitutions = {})
+    {
+        Compile(tree, dataset, reuseColumns, substitutions);
+    }
+
+    // (re)compile the tape for the given tree, reusing the storage of the previous instructions
+    void Compile(Tree const& tree, Dataset const& dataset, bool reuseColumns = true, gsl::span<Operon::Scalar const* const> substitutions = {});
+
+    gsl::span<const Instruction> Instructions() const noexcept { return instructions; }
+    gsl::span<const size_t> Arguments(Instruction const& instr) const noexcept { return { arguments.data() + instr.Arguments, instr.Arity }; }
+
+    // number of scratch columns required to run this tape
+    size_t Columns() const noexcept { return columns; }
+    // number of leaf nodes (constants or variables) that consume a parameter
+    size_t Coefficients() const noexcept { return coefficients; }
+    // scratch column containing the final result
+    size_t Root() const noexcept { return instructions.back().Result; }
+
+    size_t Length() const noexcept { return instructions.size(); }
+    bool Empty() const noexcept { return instructions.empty(); }
+
+private:
+    std::vector<Instruction> instructions;
+    std::vector<size_t> arguments;
+    size_t columns = 0;
+    size_t coefficients = 0;
+};
+} // namespace Operon
+
+#endif
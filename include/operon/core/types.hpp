@@ -29,17 +29,32 @@
 #endif
 
 #include <cstdint>
+#include <type_traits>
 
 namespace Operon {
 using Hash = uint64_t;
 using RandomGenerator = Random::RomuTrio;
 
+// the storage precision of the datasets and the type of the coefficients and fitness values
 #if defined(USE_SINGLE_PRECISION)
 using Scalar = float;
 #else
 using Scalar = double;
 #endif
 
+// the precision used to evaluate the models is chosen at runtime (see Problem::SetPrecision),
+// the evaluation engine is compiled for both float and double
+enum class Precision : int {
+    Single,
+    Double
+};
+
+template <Precision P>
+using PrecisionType = std::conditional_t<P == Precision::Single, float, double>;
+
+template <typename T>
+inline constexpr Precision PrecisionOf = std::is_same_v<T, float> ? Precision::Single : Precision::Double;
+
 #if defined(CERES_ALWAYS_DOUBLE)
 using Dual = ceres::Jet<double, 4>;
 #else
@@ -0,0 +1,66 @@
+/* This file is part of:
+ * Operon - Large Scale Genetic Programming Framework
+ *
+ * Licensed under the ISC License <https://opensource.org/licenses/ISC>
+ * Copyright (C) 2020 Bogdan Burlacu
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+ * REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+ * INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+ * LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+ * OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+ * PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifndef OPERON_VECTORMATH
+#define OPERON_VECTORMATH
+
+#include <cstddef>
+
+// vectorized elementary functions used by the interpreter for the nonlinear nodes
+// - the implementation is selected at runtime from the instruction sets supported by the cpu (cpuid): AVX-512, AVX2 (with FMA)
+//   or a scalar fallback calling the standard library
+// - y[i] = f(x[i]) for i < n, the input and output arrays may be the same (in-place evaluation)
+// - special values (nan, inf, zero, negative arguments of log) are handled like in the standard library
+//
+// accuracy of the vectorized implementations (maximum error measured against a long double reference, see test/implementation/vectormath.cpp):
+// - exp, log, cbrt: 1 ulp
+// - sin, cos: 1.5 ulp for |x| < 100 and 2.5 ulp for |x| < 2^19, larger arguments are passed to the standard library
+// - tan: 3.5 ulp for |x| < 2^19, larger arguments are passed to the standard library
+namespace Operon::VectorMath {
+    enum class InstructionSet : int {
+        Scalar,
+        AVX2,
+        AVX512
+    };
+
+    // the best instruction set supported by the cpu (and by the build)
+    InstructionSet Supported() noexcept;
+
+    // the instruction set used by the functions below, by default the supported one
+    InstructionSet Selected() noexcept;
+
+    // select another instruction set (eg. for testing or benchmarking), which must be supported
+    void Select(InstructionSet set);
+
+    void Exp(float const* x, float* y, size_t n) noexcept;
+    void Log(float const* x, float* y, size_t n) noexcept;
+    void Sin(float const* x, float* y, size_t n) noexcept;
+    void Cos(float const* x, float* y, size_t n) noexcept;
+    void Tan(float const* x, float* y, size_t n) noexcept;
+    void Cbrt(float const* x, float* y, size_t n) noexcept;
+
+    void Exp(double const* x, double* y, size_t n) noexcept;
+    void Log(double const* x, double* y, size_t n) noexcept;
+    void Sin(double const* x, double* y, size_t n) noexcept;
+    void Cos(double const* x, double* y, size_t n) noexcept;
+    void Tan(double const* x, double* y, size_t n) noexcept;
+    void Cbrt(double const* x, double* y, size_t n) noexcept;
+} // namespace Operon::VectorMath
+
+#endif
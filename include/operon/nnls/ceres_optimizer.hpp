@@ -9,11 +9,12 @@
 #include <ceres/solver.h>
 
 namespace Operon {
-template <typename CostFunctor, typename JetT, int StorageOrder = Eigen::RowMajor>
-struct DynamicAutoDiffCostFunction final : public ceres::DynamicCostFunction {
-    using Scalar = typename JetT::Scalar;
+// adapts a cost function with the TinyCostFunction interface to the dynamic cost function interface of the big Ceres solver
+template <typename CostFunction>
+struct DynamicCostFunctionAdapter final : public ceres::DynamicCostFunction {
+    using Scalar = typename CostFunction::Scalar;
 
-    DynamicAutoDiffCostFunction(const Tree& tree, const Dataset& dataset, const gsl::span<const Operon::Scalar> targetValues, const Range range)
+    DynamicCostFunctionAdapter(const Tree& tree, const Dataset& dataset, const gsl::span<const Operon::Scalar> targetValues, const Range range)
         : cf_(tree, dataset, targetValues, range)
     {
         mutable_parameter_block_sizes()->push_back(cf_.NumParameters());
@@ -72,9 +73,15 @@ struct DynamicAutoDiffCostFunction final : public ceres::DynamicCostFunction {
     }
 
 private:
-    TinyCostFunction<CostFunctor, JetT, StorageOrder> cf_;
+    CostFunction cf_;
 };
 
+template <typename CostFunctor, typename JetT, int StorageOrder = Eigen::RowMajor>
+using DynamicAutoDiffCostFunction = DynamicCostFunctionAdapter<TinyCostFunction<CostFunctor, JetT, StorageOrder>>;
+
+template <int StorageOrder = Eigen::RowMajor>
+using DynamicReverseModeCostFunction = DynamicCostFunctionAdapter<ReverseModeCostFunction<StorageOrder>>;
+
 template <DerivativeMethod M>
 struct Optimizer<M, OptimizerType::CERES> : public OptimizerBase {
     virtual OptimizerSummary Optimize(Tree& tree, const Dataset& dataset, const gsl::span<const Operon::Scalar> targetValues, const Range range, size_t iterations = 50, bool writeCoefficients = true, bool report = false) const override
@@ -107,6 +114,8 @@ struct Optimizer<M, OptimizerType::CERES> : public OptimizerBase {
         DynamicCostFunction* costFunction;
         if constexpr (M == DerivativeMethod::AUTODIFF) {
             costFunction = new Operon::DynamicAutoDiffCostFunction<ResidualEvaluator, Dual, Eigen::RowMajor>(tree, dataset, targetValues, range);
+        } else if constexpr (M == DerivativeMethod::REVERSE) {
+            costFunction = new Operon::DynamicReverseModeCostFunction<Eigen::RowMajor>(tree, dataset, targetValues, range);
         } else {
             auto eval = new ResidualEvaluator(tree, dataset, targetValues, range);
             costFunction = new DynamicNumericDiffCostFunction(eval);
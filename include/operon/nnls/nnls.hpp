@@ -29,7 +29,7 @@
 
 namespace Operon {
 
-OptimizerSummary Optimize(Tree& tree, Dataset const& dataset, const gsl::span<const Operon::Scalar> targetValues, Range const range, size_t iterations = 50, bool writeCoefficients = true, bool report = false) {
+inline OptimizerSummary Optimize(Tree& tree, Dataset const& dataset, const gsl::span<const Operon::Scalar> targetValues, Range const range, size_t iterations = 50, bool writeCoefficients = true, bool report = false) {
 #if defined(CERES_TINY_SOLVER) || !defined(HAVE_CERES)
     Optimizer<DerivativeMethod::AUTODIFF, OptimizerType::TINY> optimizer;
 #else
@@ -37,6 +37,13 @@ OptimizerSummary Optimize(Tree& tree, Dataset const& dataset, const gsl::span<co
 #endif
     return optimizer.Optimize(tree, dataset, targetValues, range, iterations, writeCoefficients, report);
 }
+
+// optimize over the dataset rows given by `rows`, targetValues[i] being the target of row rows[i]
+// (the jacobian is computed in reverse mode by the tiny solver, independently of the configured solver)
+inline OptimizerSummary Optimize(Tree& tree, Dataset const& dataset, const gsl::span<const Operon::Scalar> targetValues, gsl::span<const size_t> rows, size_t iterations = 50, bool writeCoefficients = true) {
+    Optimizer<DerivativeMethod::REVERSE, OptimizerType::TINY> optimizer;
+    return optimizer.Optimize(tree, dataset, targetValues, rows, iterations, writeCoefficients);
+}
 }
 
 #endif
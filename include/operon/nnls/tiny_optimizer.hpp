@@ -28,6 +28,8 @@ struct TinyCostFunction {
     {
         numResiduals_ = targetValues.size();
         numParameters_ = tree.GetCoefficients().size();
+        input_jets_.resize(numParameters_);
+        output_jets_.resize(numResiduals_);
     }
 
     bool Evaluate(Scalar const* parameters, Scalar* residuals, Scalar* jacobian) const
@@ -36,9 +38,9 @@ struct TinyCostFunction {
             return functor_(&parameters, residuals);
         }
 
-        // Allocate scratch space for the strided evaluation.
-        Operon::Vector<JetT> input_jets(numParameters_);
-        Operon::Vector<JetT> output_jets(numResiduals_);
+        // Scratch space for the strided evaluation (allocated once, the solver calls this on every iteration).
+        auto& input_jets = input_jets_;
+        auto& output_jets = output_jets_;
 
         auto ptr = &input_jets[0];
 
@@ -112,10 +114,89 @@ private:
     CostFunctor functor_;
     int numResiduals_;
     int numParameters_;
+    mutable Operon::Vector<JetT> input_jets_;
+    mutable Operon::Vector<JetT> output_jets_;
+};
+
+// cost function computing the residuals and the jacobian with reverse-mode differentiation (see EvaluateJacobian in core/eval.hpp)
+// - it has the same interface as the TinyCostFunction above and can be used with both solvers
+// - the jacobian is computed in double or single precision according to Operon::Scalar
+template <int StorageOrder = Eigen::RowMajor>
+struct ReverseModeCostFunction {
+    using Scalar = Operon::Scalar;
+
+    enum {
+        NUM_RESIDUALS = Eigen::Dynamic,
+        NUM_PARAMETERS = Eigen::Dynamic,
+    };
+
+    ReverseModeCostFunction(const Tree& tree, const Dataset& dataset, const gsl::span<const Operon::Scalar> targetValues, const Range range)
+        : tape_(tree, dataset, /* reuseColumns */ false)
+        , target_(targetValues)
+        , range_(range)
+    {
+        numResiduals_ = static_cast<int>(targetValues.size());
+        numParameters_ = static_cast<int>(tape_.Coefficients());
+    }
+
+    // the residuals of the dataset rows given by `rows` (kept by reference), targetValues[i] being the target of row rows[i]
+    ReverseModeCostFunction(const Tree& tree, const Dataset& dataset, const gsl::span<const Operon::Scalar> targetValues, gsl::span<const size_t> rows)
+        : tape_(tree, dataset, /* reuseColumns */ false)
+        , target_(targetValues)
+        , rows_(rows)
+    {
+        EXPECT(rows.size() == targetValues.size());
+        numResiduals_ = static_cast<int>(targetValues.size());
+        numParameters_ = static_cast<int>(tape_.Coefficients());
+    }
+
+    bool Evaluate(Scalar const* parameters, Scalar* residuals, Scalar* jacobian) const
+    {
+        gsl::span<Scalar> result(residuals, static_cast<size_t>(numResiduals_));
+
+        if (jacobian == nullptr) {
+            if (rows_.empty()) {
+                Operon::Evaluate<Scalar>(tape_, range_, result, parameters);
+            } else {
+                Operon::Evaluate<Scalar>(tape_, rows_, result, parameters);
+            }
+        } else {
+            gsl::span<Scalar> jac(jacobian, static_cast<size_t>(numResiduals_) * static_cast<size_t>(numParameters_));
+            if (rows_.empty()) {
+                Operon::EvaluateJacobian<Scalar, StorageOrder>(tape_, range_, result, jac, parameters);
+            } else {
+                Operon::EvaluateJacobian<Scalar, StorageOrder>(tape_, rows_, result, jac, parameters);
+            }
+        }
+
+        Eigen::Map<Eigen::Array<Scalar, Eigen::Dynamic, 1>> resMap(residuals, numResiduals_);
+        Eigen::Map<const Eigen::Array<Operon::Scalar, Eigen::Dynamic, 1>> targetMap(target_.data(), numResiduals_);
+        resMap -= targetMap;
+        return true;
+    }
+
+    // required by tiny solver
+    bool operator()(Scalar const* parameters, Scalar* residuals, Scalar* jacobian) const
+    {
+        return Evaluate(parameters, residuals, jacobian);
+    }
+
+    int NumResiduals() const { return numResiduals_; }
+    int NumParameters() const { return numParameters_; }
+
+private:
+    Tape tape_;
+    gsl::span<const Operon::Scalar> target_;
+    Range range_;
+    gsl::span<const size_t> rows_; // empty for the range
+    int numResiduals_;
+    int numParameters_;
 };
 
 enum class OptimizerType : int { TINY, CERES };
-enum class DerivativeMethod : int { NUMERIC, AUTODIFF };
+// AUTODIFF uses forward-mode dual numbers (one pass over the data for every Dual::DIMENSION coefficients)
+// REVERSE uses adjoint propagation (one forward and one backward pass, regardless of the number of coefficients)
+enum class DerivativeMethod : int { NUMERIC, AUTODIFF, REVERSE };
 
 struct OptimizerSummary {
     double InitialCost;
@@ -129,16 +210,35 @@ struct OptimizerBase {
     virtual ~OptimizerBase() { }
 };
 
-template <DerivativeMethod = DerivativeMethod::AUTODIFF, OptimizerType T = OptimizerType::TINY>
+template <DerivativeMethod M = DerivativeMethod::AUTODIFF, OptimizerType T = OptimizerType::TINY>
 struct Optimizer : public OptimizerBase {
     virtual OptimizerSummary Optimize(Tree& tree, Dataset const& dataset, const gsl::span<const Operon::Scalar> targetValues, Range const range, size_t iterations = 50, bool writeCoefficients = true, bool = false /* not used by tiny solver */) const override
     {
-        Operon::TinyCostFunction<ResidualEvaluator, Dual, Eigen::ColMajor> cf(tree, dataset, targetValues, range);
-        ceres::TinySolver<decltype(cf)> solver;
+        if constexpr (M == DerivativeMethod::REVERSE) {
+            Operon::ReverseModeCostFunction<Eigen::ColMajor> cf(tree, dataset, targetValues, range);
+            return Solve(cf, tree, iterations, writeCoefficients);
+        } else {
+            Operon::TinyCostFunction<ResidualEvaluator, Dual, Eigen::ColMajor> cf(tree, dataset, targetValues, range);
+            return Solve(cf, tree, iterations, writeCoefficients);
+        }
+    }
+
+    // optimize over the dataset rows given by `rows` (see ReverseModeCostFunction), whatever the derivative method
+    OptimizerSummary Optimize(Tree& tree, Dataset const& dataset, const gsl::span<const Operon::Scalar> targetValues, gsl::span<const size_t> rows, size_t iterations = 50, bool writeCoefficients = true) const
+    {
+        Operon::ReverseModeCostFunction<Eigen::ColMajor> cf(tree, dataset, targetValues, rows);
+        return Solve(cf, tree, iterations, writeCoefficients);
+    }
+
+private:
+    template <typename CostFunction>
+    static OptimizerSummary Solve(CostFunction const& cf, Tree& tree, size_t iterations, bool writeCoefficients)
+    {
+        ceres::TinySolver<CostFunction> solver;
         solver.options.max_num_iterations = static_cast<int>(iterations);
 
         auto x0 = tree.GetCoefficients();
-        decltype(solver)::Parameters params = Eigen::Map<Eigen::Matrix<Operon::Scalar, Eigen::Dynamic, 1>>(x0.data(), x0.size()).cast<typename decltype(cf)::Scalar>();
+        typename decltype(solver)::Parameters params = Eigen::Map<Eigen::Matrix<Operon::Scalar, Eigen::Dynamic, 1>>(x0.data(), x0.size()).cast<typename CostFunction::Scalar>();
         solver.Solve(cf, &params);
 
         if (writeCoefficients) {
@@ -20,13 +20,21 @@
 #ifndef EVALUATOR_HPP
 #define EVALUATOR_HPP
 
+#include "core/eval.hpp"
 #include "core/metrics.hpp"
 #include "core/operator.hpp"
 #include "core/types.hpp"
 #include "nnls/nnls.hpp"
+#include "stat/linearscaler.hpp"
 #include "stat/meanvariance.hpp"
 #include "stat/pearson.hpp"
 
+#include <algorithm>
+#include <array>
+#include <execution>
+#include <limits>
+#include <numeric>
+
 namespace Operon {
 
 class UserDefinedEvaluator : public EvaluatorBase {
@@ -63,6 +71,306 @@ private:
     std::function<typename EvaluatorBase::ReturnType(Operon::RandomGenerator*, Operon::Individual&)> fptr; // workaround for pybind11
 };
 
+namespace detail {
+    // number of trees evaluated together (over the same tiles of rows) when scoring a batch of individuals
+    constexpr size_t EvaluationGroupSize = 32;
+
+    // evaluates the genotype over the range
+    // - with incremental evaluation, the individual's trace (inherited from its parent for mutation-only offspring) is
+    //   used to only evaluate the changed nodes, then replaced with the trace of the genotype
+    // - otherwise with a subtree cache, the genotype is hashed in strict mode so that the cache keys reflect the current coefficients
+    inline void EstimateValues(Individual& individual, Dataset const& dataset, Range const range, gsl::span<Operon::Scalar> result, SubtreeCache* cache, bool incremental, EvaluationContext<Operon::Scalar>& context)
+    {
+        auto& genotype = individual.Genotype;
+        if (incremental) {
+            individual.Trace = EvaluateIncremental(genotype, dataset, range, result, individual.Trace, context);
+            return;
+        }
+        if (cache != nullptr) {
+            genotype.Hash<Operon::HashFunction::XXHash>(Operon::HashMode::Strict);
+            Evaluate(genotype, dataset, range, result, *cache, context);
+            return;
+        }
+        Evaluate<Operon::Scalar>(genotype, dataset, range, result, nullptr, context);
+    }
+
+    // the returned values are stored in the context and remain valid until its next use
+    inline gsl::span<Operon::Scalar> EstimateValues(Individual& individual, Dataset const& dataset, Range const range, SubtreeCache* cache, bool incremental, EvaluationContext<Operon::Scalar>& context = EvaluationContext<Operon::Scalar>::Default())
+    {
+        auto result = context.Values(range.Size());
+        EstimateValues(individual, dataset, range, result, cache, incremental, context);
+        return result;
+    }
+
+    // the target values of the training set in the storage precision, gathered into `buffer` if the problem has training rows
+    inline gsl::span<Operon::Scalar const> TrainingTarget(Problem const& problem, Operon::Vector<Operon::Scalar>& buffer)
+    {
+        auto column = problem.GetDataset().GetValues(problem.TargetVariable());
+        auto rows = problem.TrainingRows();
+        if (rows.empty()) {
+            auto range = problem.TrainingRange();
+            return column.subspan(range.Start(), range.Size());
+        }
+        buffer.resize(rows.size());
+        std::transform(rows.begin(), rows.end(), buffer.begin(), [&](auto row) { return column[row]; });
+        return buffer;
+    }
+
+    // optimizes the coefficients of the tree over the training set of the problem, given its target values (see TrainingTarget)
+    inline OptimizerSummary OptimizeCoefficients(Tree& tree, Problem const& problem, gsl::span<Operon::Scalar const> targetValues, size_t iterations)
+    {
+        auto rows = problem.TrainingRows();
+        if (rows.empty()) {
+            return Operon::Optimize(tree, problem.GetDataset(), targetValues, problem.TrainingRange(), iterations);
+        }
+        return Operon::Optimize(tree, problem.GetDataset(), targetValues, rows, iterations);
+    }
+
+    // EvaluateAndReduce over a range or a list of rows, in batches of the given number of rows (see WithBatchSize)
+    template <typename T, typename Rows, typename F>
+    bool ReduceInBatches(Tape const& tape, Rows const& rows, F&& consume, size_t batchSize)
+    {
+        return WithBatchSize<T>(batchSize, tape.Columns(), [&](auto s) {
+            constexpr size_t S = decltype(s)::value;
+            return EvaluateAndReduce<T, S>(tape, rows, consume, nullptr, EvaluationContext<T, S>::Default());
+        });
+    }
+
+    // same as above over a range of the dataset, streamed chunk by chunk (see ForEachChunk). the offsets passed to
+    // `consume` remain relative to range.Start()
+    template <typename T, typename F>
+    bool ReduceInBatches(Tape const& tape, Dataset const& dataset, Range const range, F&& consume, size_t batchSize)
+    {
+        return ForEachChunk(dataset, range, [&](Range chunk) {
+            auto shift = chunk.Start() - range.Start();
+            return ReduceInBatches<T>(tape, chunk, [&](gsl::span<T const> values, size_t offset) { return consume(values, shift + offset); }, batchSize);
+        });
+    }
+
+    // scores the individual with the evaluator E without materializing the estimated values: the statistics of E::Calculator
+    // are accumulated from each batch of rows while it is still in cache (see EvaluateAndReduce)
+    // - the values are still written out with a subtree cache or incremental evaluation, which need them, or by the JIT backend
+    // - T is the evaluation precision, the subtree cache and the incremental evaluation are only used in the storage precision
+    // - the fused evaluation runs in batches of `batchSize` rows (see WithBatchSize), zero selecting the batch size from the tape
+    template <typename E, typename T>
+    Operon::Scalar Score(Individual& individual, Dataset const& dataset, gsl::span<T const> targetValues, Range const range, SubtreeCache* cache, bool incremental, size_t batchSize, EvaluationContext<T>& context = EvaluationContext<T>::Default())
+    {
+        typename E::Calculator calculator;
+        if constexpr (std::is_same_v<T, Operon::Scalar>) {
+            bool fused = cache == nullptr && !incremental;
+#if defined(USE_LLVM_JIT)
+            fused = false;
+#endif
+            if (!fused) {
+                E::Accumulate(calculator, gsl::span<T const>(EstimateValues(individual, dataset, range, cache, incremental, context)), targetValues);
+                return E::Score(calculator);
+            }
+        }
+        auto const& tape = context.Compile(individual.Genotype, dataset);
+        ReduceInBatches<T>(tape, dataset, range, [&](gsl::span<T const> values, size_t offset) {
+            E::Accumulate(calculator, values, targetValues.subspan(offset, values.size()));
+        }, batchSize);
+        return E::Score(calculator);
+    }
+
+    // the target values of a batch of rows (rows[offset], ..., rows[offset + size - 1]) gathered from the target column
+    template <typename T, size_t S>
+    gsl::span<T const> GatherTarget(gsl::span<T const> column, gsl::span<size_t const> rows, size_t offset, size_t size, std::array<T, S>& batch)
+    {
+        EXPECT(size <= S);
+        for (size_t k = 0; k < size; ++k) {
+            batch[k] = column[rows[offset + k]];
+        }
+        return { batch.data(), size };
+    }
+
+    // scores the individual on the given dataset rows (a sample or the training rows, see EvaluatorBase::Rows), stopping early
+    // like ScoreBounded below if it cannot beat the bound. `column` holds the target values of all the dataset rows
+    template <typename E, typename T>
+    Operon::Scalar ScoreRows(Individual& individual, Dataset const& dataset, gsl::span<T const> column, gsl::span<size_t const> rows, Operon::Scalar bound, size_t batchSize, EvaluationContext<T>& context = EvaluationContext<T>::Default())
+    {
+        typename E::Calculator calculator;
+        std::array<T, BatchSizes<T>.back()> batch; // one batch of target values (of at most the largest batch size)
+        auto const& tape = context.Compile(individual.Genotype, dataset);
+        auto completed = ReduceInBatches<T>(tape, rows, [&](gsl::span<T const> values, size_t offset) {
+            E::Accumulate(calculator, values, GatherTarget(column, rows, offset, values.size(), batch));
+            return E::MinimumScore(calculator, rows.size()) < bound;
+        }, batchSize);
+        auto score = completed ? E::Score(calculator) : EvaluatorBase::RejectedFitness;
+        return score < bound ? score : EvaluatorBase::RejectedFitness;
+    }
+
+    // scores the individual over the given rows (see EvaluatorBase::Rows) or the training range if empty, in the precision of the problem
+    template <typename E>
+    Operon::Scalar Score(Individual& individual, Problem const& problem, gsl::span<size_t const> rows, SubtreeCache* cache, bool incremental, size_t batchSize)
+    {
+        auto const& dataset = problem.GetDataset();
+        auto trainingRange = problem.TrainingRange();
+        auto score = [&](auto t) {
+            using T = decltype(t);
+            auto column = dataset.GetValues<T>(problem.TargetVariable());
+            if (!rows.empty()) {
+                return ScoreRows<E, T>(individual, dataset, column, rows, std::numeric_limits<Operon::Scalar>::infinity(), batchSize); // no bound
+            }
+            return Score<E, T>(individual, dataset, column.subspan(trainingRange.Start(), trainingRange.Size()), trainingRange, cache, incremental, batchSize);
+        };
+        return problem.GetPrecision() == Precision::Single ? score(float {}) : score(double {});
+    }
+
+    // scores the individual like Score, but stops as soon as E::MinimumScore(calculator, range.Size()), a lower bound of the final
+    // score computed from the statistics of the rows evaluated so far, is not below `bound`. then RejectedFitness is returned
+    // (as it is when the final score is not below the bound), which is what the caller needs when it would discard such an individual
+    template <typename E, typename T>
+    Operon::Scalar ScoreBounded(Individual& individual, Dataset const& dataset, gsl::span<T const> targetValues, Range const range, Operon::Scalar bound, size_t batchSize, EvaluationContext<T>& context = EvaluationContext<T>::Default())
+    {
+        typename E::Calculator calculator;
+        auto const& tape = context.Compile(individual.Genotype, dataset);
+        auto completed = ReduceInBatches<T>(tape, dataset, range, [&](gsl::span<T const> values, size_t offset) {
+            E::Accumulate(calculator, values, targetValues.subspan(offset, values.size()));
+            return E::MinimumScore(calculator, range.Size()) < bound;
+        }, batchSize);
+        auto score = completed ? E::Score(calculator) : EvaluatorBase::RejectedFitness;
+        return score < bound ? score : EvaluatorBase::RejectedFitness;
+    }
+
+    // scores the individual over the training range in the precision of the problem, stopping early if it cannot beat the bound
+    // (the early stop needs the fused evaluation, so it is not used with a subtree cache, incremental evaluation or the JIT backend)
+    template <typename E>
+    Operon::Scalar ScoreBounded(Individual& individual, Problem const& problem, gsl::span<size_t const> rows, SubtreeCache* cache, bool incremental, size_t batchSize, Operon::Scalar bound)
+    {
+        bool fused = cache == nullptr && !incremental;
+#if defined(USE_LLVM_JIT)
+        fused = false;
+#endif
+        if (!fused && rows.empty()) {
+            auto score = Score<E>(individual, problem, rows, cache, incremental, batchSize);
+            return score < bound ? score : EvaluatorBase::RejectedFitness;
+        }
+        auto const& dataset = problem.GetDataset();
+        auto trainingRange = problem.TrainingRange();
+        auto score = [&](auto t) {
+            using T = decltype(t);
+            auto column = dataset.GetValues<T>(problem.TargetVariable());
+            if (!rows.empty()) {
+                return ScoreRows<E, T>(individual, dataset, column, rows, bound, batchSize);
+            }
+            return ScoreBounded<E, T>(individual, dataset, column.subspan(trainingRange.Start(), trainingRange.Size()), trainingRange, bound, batchSize);
+        };
+        return problem.GetPrecision() == Precision::Single ? score(float {}) : score(double {});
+    }
+
+    // simplifies (if simplify is true) and optimizes the coefficients of each individual (if iterations > 0), then evaluates groups of individuals
+    // over the training range (chunk by chunk, see ForEachChunk) using EvaluatePopulationAndReduce and scores them with the evaluator E,
+    // accumulating its statistics tile by tile
+    // - with a subtree cache or incremental evaluation the individuals are evaluated one by one, since each of them is partially evaluated,
+    //   and so they are with the JIT backend, which compiles each tree to native code (see EstimateValues)
+    // - with a list of rows (a sample or the training rows, see EvaluatorBase::Rows) the individuals are scored on these rows only
+    // - with prescreening, the individuals whose output is not bounded by interval arithmetic are rejected before any of the above
+    // - the groups are evaluated in batches of `batchSize` rows (see WithBatchSize), zero selecting the batch size from the largest tape of the group
+    // - T is the evaluation precision, the coefficients are always optimized in the storage precision
+    template <typename E, typename T>
+    void EvaluateIndividuals(Problem const& problem, gsl::span<size_t const> rows, gsl::span<Individual> individuals, gsl::span<Operon::Scalar> fitness, size_t iterations, std::atomic_ulong& localEvaluations, SubtreeCache* cache, bool incremental, bool simplify, bool prescreen, std::atomic_ulong& rejectedEvaluations, size_t batchSize)
+    {
+        EXPECT(individuals.size() == fitness.size());
+        auto const& dataset = problem.GetDataset();
+        auto trainingRange = problem.TrainingRange();
+        Operon::Vector<Operon::Scalar> buffer;
+        auto optimizationTarget = iterations > 0 ? TrainingTarget(problem, buffer) : gsl::span<Operon::Scalar const> {};
+        auto column = dataset.GetValues<T>(problem.TargetVariable());
+        auto targetValues = column.subspan(trainingRange.Start(), trainingRange.Size());
+        bool partial = cache != nullptr || incremental;
+#if defined(USE_LLVM_JIT)
+        partial = true;
+#endif
+        partial = partial && std::is_same_v<T, Operon::Scalar> && rows.empty();
+
+        std::vector<size_t> groups((individuals.size() + EvaluationGroupSize - 1) / EvaluationGroupSize);
+        std::iota(groups.begin(), groups.end(), 0ul);
+        std::for_each(std::execution::par_unseq, groups.begin(), groups.end(), [&](size_t g) {
+            auto first = g * EvaluationGroupSize;
+            auto last = std::min(first + EvaluationGroupSize, individuals.size());
+
+            // the tapes are kept by each thread and reused by the next groups
+            thread_local std::vector<Tape> tapes;
+            auto& context = EvaluationContext<T>::Default();
+            std::array<typename E::Calculator, EvaluationGroupSize> calculators;
+            std::array<size_t, EvaluationGroupSize> indices; // individual (relative to first) corresponding to each tape
+            std::array<bool, EvaluationGroupSize> rejected {};
+            size_t numTapes { 0 };
+
+            for (size_t i = first; i < last; ++i) {
+                auto& genotype = individuals[i].Genotype;
+                if (simplify) {
+                    genotype.Simplify();
+                }
+                if (prescreen && !EvaluateInterval(genotype, dataset).IsFinite()) {
+                    rejected[i - first] = true;
+                    ++rejectedEvaluations;
+                    continue;
+                }
+                if (iterations > 0) {
+                    auto summary = OptimizeCoefficients(genotype, problem, optimizationTarget, iterations);
+                    localEvaluations += summary.Iterations;
+                }
+                if constexpr (std::is_same_v<T, Operon::Scalar>) {
+                    if (partial) {
+                        E::Accumulate(calculators[i - first], gsl::span<T const>(EstimateValues(individuals[i], dataset, trainingRange, cache, incremental, context)), targetValues);
+                        continue;
+                    }
+                }
+                if (tapes.size() == numTapes) {
+                    tapes.emplace_back();
+                }
+                indices[numTapes] = i - first;
+                tapes[numTapes++].Compile(genotype, dataset);
+            }
+
+            auto group = gsl::span<Tape const>(tapes.data(), numTapes);
+            auto columns = std::transform_reduce(group.begin(), group.end(), size_t { 0 }, [](auto a, auto b) { return std::max(a, b); }, [](auto const& tape) { return tape.Columns(); });
+            WithBatchSize<T>(batchSize, columns, [&](auto s) {
+                constexpr size_t S = decltype(s)::value;
+                auto& batchContext = EvaluationContext<T, S>::Default();
+                if (numTapes > 0 && !rows.empty()) {
+                    std::array<T, S> batch;
+                    EvaluatePopulationAndReduce<T, S>(group, rows, [&](size_t j, gsl::span<T const> values, size_t offset) {
+                        E::Accumulate(calculators[indices[j]], values, GatherTarget(column, rows, offset, values.size(), batch));
+                    }, DefaultTileSize, batchContext);
+                } else if (numTapes > 0) {
+                    ForEachChunk(dataset, trainingRange, [&](Range chunk) {
+                        auto shift = chunk.Start() - trainingRange.Start();
+                        EvaluatePopulationAndReduce<T, S>(group, chunk, [&](size_t j, gsl::span<T const> values, size_t offset) {
+                            E::Accumulate(calculators[indices[j]], values, targetValues.subspan(shift + offset, values.size()));
+                        }, DefaultTileSize, batchContext);
+                    });
+                }
+            });
+
+            for (size_t i = first; i < last; ++i) {
+                fitness[i] = rejected[i - first] ? EvaluatorBase::RejectedFitness : E::Score(calculators[i - first]);
+            }
+        });
+    }
+
+    template <typename E>
+    void EvaluateIndividuals(Problem const& problem, gsl::span<size_t const> rows, gsl::span<Individual> individuals, gsl::span<Operon::Scalar> fitness, size_t iterations, std::atomic_ulong& localEvaluations, SubtreeCache* cache, bool incremental, bool simplify, bool prescreen, std::atomic_ulong& rejectedEvaluations, size_t batchSize)
+    {
+        if (problem.GetPrecision() == Precision::Single) {
+            EvaluateIndividuals<E, float>(problem, rows, individuals, fitness, iterations, localEvaluations, cache, incremental, simplify, prescreen, rejectedEvaluations, batchSize);
+        } else {
+            EvaluateIndividuals<E, double>(problem, rows, individuals, fitness, iterations, localEvaluations, cache, incremental, simplify, prescreen, rejectedEvaluations, batchSize);
+        }
+    }
+
+    // scores the individuals as they are (see EvaluatorBase::Rescore): like EvaluateIndividuals without simplification or
+    // coefficient optimization, the prescreening rejections are not counted either
+    template <typename E>
+    void RescoreIndividuals(Problem const& problem, gsl::span<size_t const> rows, gsl::span<Individual> individuals, gsl::span<Operon::Scalar> fitness, SubtreeCache* cache, bool incremental, bool prescreen, size_t batchSize)
+    {
+        std::atomic_ulong uncounted { 0 };
+        EvaluateIndividuals<E>(problem, rows, individuals, fitness, /* iterations */ 0, uncounted, cache, incremental, /* simplify */ false, prescreen, uncounted, batchSize);
+    }
+} // namespace detail
+
 class MeanSquaredErrorEvaluator : public EvaluatorBase {
 public:
     static constexpr Operon::Scalar LowerBound = 0.0;
@@ -73,29 +381,92 @@ public:
     {
     }
 
+    // the mean of the squared errors is accumulated batch by batch
+    using Calculator = MeanVarianceCalculator;
+
+    template <typename T>
+    static void Accumulate(Calculator& calculator, gsl::span<T const> estimatedValues, gsl::span<T const> targetValues)
+    {
+        EXPECT(estimatedValues.size() == targetValues.size());
+        for (size_t i = 0; i < estimatedValues.size(); ++i) {
+            auto e = static_cast<double>(estimatedValues[i]) - static_cast<double>(targetValues[i]);
+            calculator.Add(e * e);
+        }
+    }
+
+    // the sum of the squared errors only grows with the number of rows, so the partial sum divided by the total
+    // number of rows is a lower bound of the final mean squared error
+    static double MinimumScore(Calculator const& calculator, size_t rows)
+    {
+        return calculator.Sum() / static_cast<double>(rows);
+    }
+
+    static Operon::Scalar Score(Calculator const& calculator)
+    {
+        auto mse = calculator.Mean();
+
+        if (!std::isfinite(mse) || mse < LowerBound) {
+            mse = UpperBound;
+        }
+        return static_cast<Operon::Scalar>(mse);
+    }
+
+    static Operon::Scalar Score(gsl::span<Operon::Scalar const> estimatedValues, gsl::span<Operon::Scalar const> targetValues)
+    {
+        Calculator calculator;
+        Accumulate(calculator, estimatedValues, targetValues);
+        return Score(calculator);
+    }
+
     typename EvaluatorBase::ReturnType
-    operator()(Operon::RandomGenerator&, Individual& ind) const override
+    operator()(Operon::RandomGenerator& random, Individual& ind) const override
+    {
+        return EvaluateBounded(random, ind, UpperBound);
+    }
+
+    // the evaluation stops once the squared errors of the rows evaluated so far show that the mean squared error
+    // over the training range cannot be lower than the bound (see MinimumScore)
+    typename EvaluatorBase::ReturnType
+    EvaluateBounded(Operon::RandomGenerator&, Individual& ind, Operon::Scalar bound) const override
     {
         ++this->fitnessEvaluations;
         auto& problem_ = this->problem.get();
-        auto& dataset = problem_.GetDataset();
         auto& genotype = ind.Genotype;
 
-        auto trainingRange = problem_.TrainingRange();
-        auto targetValues = dataset.GetValues(problem_.TargetVariable()).subspan(trainingRange.Start(), trainingRange.Size());
+        if (this->simplification) {
+            genotype.Simplify();
+        }
+
+        if (this->Prescreen(genotype)) {
+            return RejectedFitness;
+        }
 
         if (this->iterations > 0) {
-            auto summary = Optimize(genotype, dataset, targetValues, trainingRange, this->iterations);
+            Operon::Vector<Operon::Scalar> buffer;
+            auto summary = detail::OptimizeCoefficients(genotype, problem_, detail::TrainingTarget(problem_, buffer), this->iterations);
             this->localEvaluations += summary.Iterations;
         }
 
-        auto estimatedValues = Evaluate<Operon::Scalar>(genotype, dataset, trainingRange);
-        auto mse = MeanSquaredError<Operon::Scalar>(estimatedValues, targetValues);
-
-        if (!std::isfinite(mse) || mse < LowerBound) {
-            mse = UpperBound;
+        if (bound >= UpperBound) {
+            return static_cast<ReturnType>(detail::Score<MeanSquaredErrorEvaluator>(ind, problem_, this->Rows(), this->subtreeCache, this->incrementalEvaluation, this->batchSize));
         }
-        return static_cast<ReturnType>(mse);
+        auto fitness = detail::ScoreBounded<MeanSquaredErrorEvaluator>(ind, problem_, this->Rows(), this->subtreeCache, this->incrementalEvaluation, this->batchSize, bound);
+        if (fitness == RejectedFitness) {
+            ++this->rejectedEvaluations;
+        }
+        return static_cast<ReturnType>(fitness);
+    }
+
+    void EvaluateBatch(Operon::RandomGenerator&, gsl::span<Individual> individuals, gsl::span<Operon::Scalar> fitness) const override
+    {
+        this->fitnessEvaluations += individuals.size();
+        detail::EvaluateIndividuals<MeanSquaredErrorEvaluator>(this->problem.get(), this->Rows(), individuals, fitness, this->iterations, this->localEvaluations, this->subtreeCache, this->incrementalEvaluation, this->simplification, this->intervalPrescreening, this->rejectedEvaluations, this->batchSize);
+    }
+
+    void Rescore(Operon::RandomGenerator&, gsl::span<Individual> individuals, gsl::span<Operon::Scalar> fitness) const override
+    {
+        this->rescoredEvaluations += individuals.size();
+        detail::RescoreIndividuals<MeanSquaredErrorEvaluator>(this->problem.get(), this->Rows(), individuals, fitness, this->subtreeCache, this->incrementalEvaluation, this->intervalPrescreening, this->batchSize);
     }
 };
 
@@ -109,41 +480,76 @@ public:
     {
     }
 
+    // the estimated and target values are accumulated batch by batch, the scaled error follows from their (co)variances:
+    // with beta = cov(x, y) / var(x) and alpha = mean(y) - beta * mean(x), the mean of (beta * x + alpha - y)^2
+    // equals beta^2 * var(x) - 2 * beta * cov(x, y) + var(y)
+    using Calculator = PearsonsRCalculator;
+
+    template <typename T>
+    static void Accumulate(Calculator& calculator, gsl::span<T const> estimatedValues, gsl::span<T const> targetValues)
+    {
+        EXPECT(estimatedValues.size() == targetValues.size());
+        calculator.Add(estimatedValues, targetValues);
+    }
+
+    // the error of the linearly scaled values can still decrease with more rows, the partial statistics give no better bound
+    static double MinimumScore(Calculator const&, size_t) { return LowerBound; }
+
+    static Operon::Scalar Score(Calculator const& calculator)
+    {
+        auto b = LinearScalingCalculator::Calculate(calculator).second;
+        auto xvar = calculator.NaiveVarianceX();
+        auto yvar = calculator.NaiveVarianceY();
+        auto errmean = std::max(b * b * xvar - 2 * b * calculator.NaiveCovariance() + yvar, 0.0);
+        auto nmse = yvar > 0 ? errmean / yvar : yvar;
+
+        if (!std::isfinite(nmse) || nmse < LowerBound) {
+            nmse = UpperBound;
+        }
+        return static_cast<Operon::Scalar>(nmse);
+    }
+
+    static Operon::Scalar Score(gsl::span<Operon::Scalar const> estimatedValues, gsl::span<Operon::Scalar const> targetValues)
+    {
+        Calculator calculator;
+        Accumulate(calculator, estimatedValues, targetValues);
+        return Score(calculator);
+    }
+
     typename EvaluatorBase::ReturnType
     operator()(Operon::RandomGenerator&, Individual& ind) const override
     {
         ++this->fitnessEvaluations;
         auto& problem_ = this->problem.get();
-        auto& dataset = problem_.GetDataset();
         auto& genotype = ind.Genotype;
 
-        auto trainingRange = problem_.TrainingRange();
-        auto targetValues = dataset.GetValues(problem_.TargetVariable()).subspan(trainingRange.Start(), trainingRange.Size());
+        if (this->simplification) {
+            genotype.Simplify();
+        }
+
+        if (this->Prescreen(genotype)) {
+            return RejectedFitness;
+        }
 
         if (this->iterations > 0) {
-            auto summary = Optimize(genotype, dataset, targetValues, trainingRange, this->iterations);
+            Operon::Vector<Operon::Scalar> buffer;
+            auto summary = detail::OptimizeCoefficients(genotype, problem_, detail::TrainingTarget(problem_, buffer), this->iterations);
             this->localEvaluations += summary.Iterations;
         }
 
-        auto estimatedValues = Evaluate<Operon::Scalar>(genotype, dataset, trainingRange);
-        // scale values
-        auto s = LinearScalingCalculator::Calculate(estimatedValues.begin(), estimatedValues.end(), targetValues.begin());
-        auto a = static_cast<Operon::Scalar>(s.first);
-        auto b = static_cast<Operon::Scalar>(s.second);
+        return static_cast<ReturnType>(detail::Score<NormalizedMeanSquaredErrorEvaluator>(ind, problem_, this->Rows(), this->subtreeCache, this->incrementalEvaluation, this->batchSize));
+    }
 
-        PearsonsRCalculator calc;
-        for(size_t i = 0; i < estimatedValues.size(); ++i) {
-            auto e = estimatedValues[i] * b + a - targetValues[i];
-            calc.Add(e * e, targetValues[i]);
-        }
-        auto yvar = calc.NaiveVarianceY();
-        auto errmean = calc.MeanX();
-        auto nmse = yvar > 0 ? errmean / yvar : yvar;
+    void EvaluateBatch(Operon::RandomGenerator&, gsl::span<Individual> individuals, gsl::span<Operon::Scalar> fitness) const override
+    {
+        this->fitnessEvaluations += individuals.size();
+        detail::EvaluateIndividuals<NormalizedMeanSquaredErrorEvaluator>(this->problem.get(), this->Rows(), individuals, fitness, this->iterations, this->localEvaluations, this->subtreeCache, this->incrementalEvaluation, this->simplification, this->intervalPrescreening, this->rejectedEvaluations, this->batchSize);
+    }
 
-        if (!std::isfinite(nmse) || nmse < LowerBound) {
-            nmse = UpperBound;
-        }
-        return static_cast<ReturnType>(nmse);
+    void Rescore(Operon::RandomGenerator&, gsl::span<Individual> individuals, gsl::span<Operon::Scalar> fitness) const override
+    {
+        this->rescoredEvaluations += individuals.size();
+        detail::RescoreIndividuals<NormalizedMeanSquaredErrorEvaluator>(this->problem.get(), this->Rows(), individuals, fitness, this->subtreeCache, this->incrementalEvaluation, this->intervalPrescreening, this->batchSize);
     }
 };
 
@@ -157,25 +563,20 @@ public:
     {
     }
 
-    typename EvaluatorBase::ReturnType
-    operator()(Operon::RandomGenerator&, Individual& ind) const
-    {
-        ++this->fitnessEvaluations;
-        auto const& problem = this->problem.get();
-        auto const& dataset = problem.GetDataset();
-        auto& genotype = ind.Genotype;
+    using Calculator = PearsonsRCalculator;
 
-        auto trainingRange = problem.TrainingRange();
-        auto targetValues = dataset.GetValues(problem.TargetVariable()).subspan(trainingRange.Start(), trainingRange.Size());
+    template <typename T>
+    static void Accumulate(Calculator& calculator, gsl::span<T const> estimatedValues, gsl::span<T const> targetValues)
+    {
+        EXPECT(estimatedValues.size() == targetValues.size());
+        calculator.Add(estimatedValues, targetValues);
+    }
 
-        if (this->iterations > 0) {
-            auto summary = Optimize(genotype, dataset, targetValues, trainingRange, this->iterations);
-            this->localEvaluations += summary.Iterations;
-        }
+    // the correlation can still increase with more rows, the partial statistics give no better bound
+    static double MinimumScore(Calculator const&, size_t) { return LowerBound; }
 
-        auto estimatedValues = Evaluate<Operon::Scalar>(genotype, dataset, trainingRange);
-        PearsonsRCalculator calculator;
-        calculator.Add(gsl::span<Operon::Scalar const>(estimatedValues), targetValues);
+    static Operon::Scalar Score(Calculator const& calculator)
+    {
         auto varX = calculator.NaiveVarianceX();
         if (varX < 1e-12) {
             // this is done to avoid numerical issues when a constant model
@@ -185,10 +586,55 @@ public:
         }
         auto r = calculator.Correlation();
         auto r2 = r * r;
-        if (!std::isfinite(r2) || r2 > UpperBound || r2 < LowerBound) {
+        if (!std::isfinite(r2)) {
             r2 = 0;
         }
-        return static_cast<ReturnType>(UpperBound - r2 + LowerBound);
+        // a perfect correlation can exceed one by a rounding error, depending on the order in which the values were accumulated
+        r2 = std::clamp(r2, double { LowerBound }, double { UpperBound });
+        return static_cast<Operon::Scalar>(UpperBound - r2 + LowerBound);
+    }
+
+    static Operon::Scalar Score(gsl::span<Operon::Scalar const> estimatedValues, gsl::span<Operon::Scalar const> targetValues)
+    {
+        Calculator calculator;
+        Accumulate(calculator, estimatedValues, targetValues);
+        return Score(calculator);
+    }
+
+    typename EvaluatorBase::ReturnType
+    operator()(Operon::RandomGenerator&, Individual& ind) const
+    {
+        ++this->fitnessEvaluations;
+        auto const& problem = this->problem.get();
+        auto& genotype = ind.Genotype;
+
+        if (this->simplification) {
+            genotype.Simplify();
+        }
+
+        if (this->Prescreen(genotype)) {
+            return RejectedFitness;
+        }
+
+        if (this->iterations > 0) {
+            Operon::Vector<Operon::Scalar> buffer;
+            auto summary = detail::OptimizeCoefficients(genotype, problem, detail::TrainingTarget(problem, buffer), this->iterations);
+            this->localEvaluations += summary.Iterations;
+        }
+
+        return static_cast<ReturnType>(detail::Score<RSquaredEvaluator>(ind, problem, this->Rows(), this->subtreeCache, this->incrementalEvaluation, this->batchSize));
+    }
+
+    void EvaluateBatch(Operon::RandomGenerator&, gsl::span<Individual> individuals, gsl::span<Operon::Scalar> fitness) const override
+    {
+        this->fitnessEvaluations += individuals.size();
+        detail::EvaluateIndividuals<RSquaredEvaluator>(this->problem.get(), this->Rows(), individuals, fitness, this->iterations, this->localEvaluations, this->subtreeCache, this->incrementalEvaluation, this->simplification, this->intervalPrescreening, this->rejectedEvaluations, this->batchSize);
+    }
+
+    void Rescore(Operon::RandomGenerator&, gsl::span<Individual> individuals, gsl::span<Operon::Scalar> fitness) const override
+    {
+        this->rescoredEvaluations += individuals.size();
+        detail::RescoreIndividuals<RSquaredEvaluator>(this->problem.get(), this->Rows(), individuals, fitness, this->subtreeCache, this->incrementalEvaluation, this->intervalPrescreening, this->batchSize);
     }
 };
 }
@@ -51,9 +51,12 @@ public:
         }
 
         if (doMutation) {
-            child.Genotype = doCrossover
-                ? this->mutator(random, std::move(child.Genotype))
-                : this->mutator(random, population[first].Genotype);
+            this->Mutate(random, child, population[first], doCrossover);
+        }
+
+        if (deferEvaluation) {
+            child[0] = Operon::Numeric::Max<Operon::Scalar>();
+            return std::make_optional(child);
         }
 
         auto f = this->evaluator(random, child);
@@ -61,6 +64,15 @@ public:
         child[0] = f;
         return std::make_optional(child);
     }
+
+    // when evaluation is deferred the offspring are returned unevaluated so they can be scored in batch
+    // (the budget does not change while a generation is produced, so the evaluations of the last generation's
+    // offspring, including their local optimization, can exceed it)
+    void SetDeferredEvaluation(bool value) { deferEvaluation = value; }
+    bool DeferredEvaluation() const override { return deferEvaluation; }
+
+private:
+    bool deferEvaluation = false;
 };
 
 } // namespace Operon
@@ -40,7 +40,8 @@ public:
         auto second = this->maleSelector(random);
 
         // assuming the basic generator never fails
-        auto makeOffspring = [&]() {
+        // only the best offspring of the brood is kept, so each offspring is evaluated against the best one so far
+        auto makeOffspring = [&](Operon::Scalar bound) {
             Individual child(1);
 
             bool doCrossover = std::bernoulli_distribution(pCrossover)(random);
@@ -51,21 +52,19 @@ public:
             }
 
             if (doMutation) {
-                child.Genotype = doCrossover
-                    ? this->mutator(random, std::move(child.Genotype))
-                    : this->mutator(random, population[first].Genotype);
+                this->Mutate(random, child, population[first], doCrossover);
             }
 
-            auto f = this->evaluator(random, child);
+            auto f = this->evaluator.get().EvaluateBounded(random, child, bound);
             if (!std::isfinite(f)) { f = Operon::Numeric::Max<Operon::Scalar>(); }
             child[0] = f;
             return child;
         };
 
-        auto best = makeOffspring();
+        auto best = makeOffspring(Operon::Numeric::Max<Operon::Scalar>());
 
         for (size_t i = 1; i < broodSize; ++i) {
-            auto other = makeOffspring();
+            auto other = makeOffspring(best[0]);
             if (other[0] < best[0]) {
                 std::swap(best, other);
             }
@@ -57,14 +57,14 @@ public:
         }
 
         if (doMutation) {
-            child.Genotype = doCrossover
-                ? this->mutator(random, std::move(child.Genotype))
-                : this->mutator(random, population[first].Genotype);
+            this->Mutate(random, child, population[first], doCrossover);
         }
 
-        auto f = this->evaluator(random, child);
+        // the child is only kept if it beats the threshold, so its evaluation can stop as soon as it cannot
+        auto threshold = static_cast<Operon::Scalar>(std::max(f1, f2) - comparisonFactor * std::abs(f1 - f2));
+        auto f = this->evaluator.get().EvaluateBounded(random, child, threshold);
 
-        if (std::isfinite(f) && f < (std::max(f1, f2) - comparisonFactor * std::abs(f1 - f2))) {
+        if (std::isfinite(f) && f < threshold) {
             child[0] = f;
             return std::make_optional(child);
         }
@@ -53,9 +53,7 @@ public:
             }
 
             if (doMutation) {
-                child.Genotype = doCrossover
-                    ? this->mutator(random, std::move(child.Genotype))
-                    : this->mutator(random, population[first].Genotype);
+                this->Mutate(random, child, population[first], doCrossover);
             }
 
             auto f = this->evaluator(random, child);
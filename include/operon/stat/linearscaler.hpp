@@ -24,6 +24,8 @@
 #include "stat/meanvariance.hpp"
 #include "stat/pearson.hpp"
 
+#include <tuple>
+
 namespace Operon {
     class LinearScalingCalculator {
         public:
@@ -40,10 +42,7 @@ namespace Operon {
             void Add(T original, T target)
             {
                 calc.Add(original, target);
-
-                auto variance = calc.Count() > 1 ? calc.SampleVarianceX() : 0;
-                beta = variance < std::numeric_limits<double>::epsilon() ? 1 : (calc.SampleCovariance() / variance);
-                alpha = calc.MeanY() - beta * calc.MeanX();
+                std::tie(alpha, beta) = Calculate(calc);
             }
             double Beta() const { return beta; }
             double Alpha() const { return alpha; }
@@ -59,6 +58,15 @@ namespace Operon {
                 return { calc.Alpha(), calc.Beta() };
             }
 
+            // calculate the coefficients from the statistics of the (original, target) pairs
+            static std::pair<double, double> Calculate(PearsonsRCalculator const& calc)
+            {
+                auto variance = calc.Count() > 1 ? calc.SampleVarianceX() : 0;
+                auto b = variance < std::numeric_limits<double>::epsilon() ? 1 : (calc.SampleCovariance() / variance);
+                auto a = calc.MeanY() - b * calc.MeanX();
+                return { a, b };
+            }
+
         private:
             double alpha; // additive constant
             double beta; // multiplicative factor
@@ -65,6 +65,22 @@ public:
     template <typename T>
     void Add(gsl::span<const T> values, gsl::span<const T> weights);
 
+    // merge the statistics of another calculator (eg. accumulated over a different partition of the data)
+    void Add(MeanVarianceCalculator const& other)
+    {
+        if (other.n <= 0) {
+            return;
+        }
+        if (n <= 0) {
+            *this = other;
+            return;
+        }
+        double d = other.n * s - n * other.s;
+        q += other.q + d * d / (n * other.n * (n + other.n));
+        s += other.s;
+        n += other.n;
+    }
+
     template <typename T>
     void Add(std::vector<T> const& values) { Add(gsl::span<const T> { values.data(), values.size() }); }
 
@@ -93,6 +109,7 @@ public:
     double NaiveStandardDeviation() const { return std::sqrt(NaiveVariance()); }
     double SampleStandardDeviation() const { return std::sqrt(SampleVariance()); }
     double Count() const { return n; }
+    double Sum() const { return s; }
     double Mean() const { return s / n; }
 
 private:
@@ -105,6 +105,28 @@ public:
     template <typename T>
     void Add(gsl::span<const T> x, gsl::span<const T> y);
 
+    // merge the statistics of another calculator (eg. accumulated over a different partition of the data)
+    void Add(PearsonsRCalculator const& other)
+    {
+        if (other.sumWe <= 0.) {
+            return;
+        }
+        if (sumWe <= 0.) {
+            *this = other;
+            return;
+        }
+        // see Schubert et al. - Numerically Stable Parallel Computation of (Co-)Variance, eq. 22-26
+        double dx = other.sumWe * sumX - sumWe * other.sumX;
+        double dy = other.sumWe * sumY - sumWe * other.sumY;
+        double f = 1. / (sumWe * other.sumWe * (sumWe + other.sumWe));
+        sumXX += other.sumXX + f * dx * dx;
+        sumYY += other.sumYY + f * dy * dy;
+        sumXY += other.sumXY + f * dx * dy;
+        sumX += other.sumX;
+        sumY += other.sumY;
+        sumWe += other.sumWe;
+    }
+
     // forwarding methods
     template <typename T>
     void Add(std::vector<T> const& x, std::vector<T> const& y)
@@ -41,6 +41,7 @@ class SymbolicRegressor(BaseEstimator, RegressorMixin):
         generations                    = 1000,
         max_evaluations                = int(1000 * 1000),
         local_iterations               = 0,
+        sample_size                    = 0,
         max_selection_pressure         = 100,
         comparison_factor              = 0,
         brood_size                     = 10,
@@ -69,6 +70,7 @@ class SymbolicRegressor(BaseEstimator, RegressorMixin):
         self.generations               = 1000 if generations is None else int(generations)
         self.max_evaluations           = 1000000 if max_evaluations is None else int(max_evaluations)
         self.local_iterations          = 0 if local_iterations is None else int(local_iterations)
+        self.sample_size               = 0 if sample_size is None else sample_size
         self.max_selection_pressure    = 100 if max_selection_pressure is None else int(max_selection_pressure)
         self.comparison_factor         = 0 if comparison_factor is None else comparison_factor
         self.brood_size                = 10 if brood_size is None else int(brood_size)
@@ -250,6 +252,10 @@ class SymbolicRegressor(BaseEstimator, RegressorMixin):
         evaluator             = self.__init_evaluator(self.error_metric, problem)
         evaluator.Budget      = self.max_evaluations;
         evaluator.LocalOptimizationIterations = self.local_iterations
+        # score on a random sample of the training rows (a number of rows or a fraction), redrawn each generation
+        if self.sample_size > 0:
+            sample_size       = int(self.sample_size * ds.Rows) if isinstance(self.sample_size, float) else int(self.sample_size)
+            evaluator.SetSampleSize(max(sample_size, 1))
 
         female_selector       = self.__init_selector(self.female_selector, 0)
         male_selector         = self.__init_selector(self.male_selector, 0)
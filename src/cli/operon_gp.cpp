@@ -20,9 +20,11 @@
 #include <cstdlib>
 
 #include <cxxopts.hpp>
+#include <exception>
 #include <fmt/core.h>
 
 #include <tbb/global_control.h>
+#include <string_view>
 #include <thread>
 
 #include "algorithms/gp.hpp"
@@ -48,10 +50,26 @@ using namespace Operon;
 
 int main(int argc, char** argv)
 {
+    // convert a csv file (with a header) to the binary dataset format, which is mapped into memory instead of parsed
+    if (argc > 1 && std::string_view(argv[1]) == "convert") {
+        if (argc != 4) {
+            fmt::print(stderr, "Usage: {} convert <input.csv> <output>\n", argv[0]);
+            exit(EXIT_FAILURE);
+        }
+        try {
+            Dataset(argv[2], true).WriteBinary(argv[3]);
+        } catch (std::exception& e) {
+            fmt::print(stderr, "{}\n", e.what());
+            exit(EXIT_FAILURE);
+        }
+        exit(EXIT_SUCCESS);
+    }
+
     cxxopts::Options opts("operon_cli", "C++ large-scale genetic programming");
+    opts.custom_help("[OPTION...]\n  operon_cli convert <input.csv> <output> (convert a csv file to the binary dataset format)");
 
     opts.add_options()
-        ("dataset", "Dataset file name (csv) (required)", cxxopts::value<std::string>())
+        ("dataset", "Dataset file name (csv with a header, or binary, see convert) (required)", cxxopts::value<std::string>())
         ("shuffle", "Shuffle the input data", cxxopts::value<bool>()->default_value("false"))
         ("standardize", "Standardize the training partition (zero mean, unit variance)", cxxopts::value<bool>()->default_value("false"))
         ("train", "Training range specified as start:end (required)", cxxopts::value<std::string>())
@@ -74,9 +92,15 @@ int main(int argc, char** argv)
         ("female-selector", "Female selection operator, with optional parameters separated by : (eg, --selector tournament:5)", cxxopts::value<std::string>())
         ("male-selector", "Male selection operator, with optional parameters separated by : (eg, --selector tournament:5)", cxxopts::value<std::string>())
         ("offspring-generator", "OffspringGenerator operator, with optional parameters separated by : (eg --offspring-generator brood:10:10)", cxxopts::value<std::string>())
+        ("deferred-evaluation", "Evaluate the offspring of the basic generator in batch after each generation (the evaluation budget is then only checked between generations)", cxxopts::value<bool>()->default_value("false"))
         ("reinserter", "Reinsertion operator merging offspring in the recombination pool back into the population", cxxopts::value<std::string>())
         ("enable-symbols", "Comma-separated list of enabled symbols (add, sub, mul, div, exp, log, sin, cos, tan, sqrt, cbrt)", cxxopts::value<std::string>())
         ("disable-symbols", "Comma-separated list of disabled symbols (add, sub, mul, div, exp, log, sin, cos, tan, sqrt, cbrt)", cxxopts::value<std::string>())
+        ("precision", "Precision used to evaluate the models during the run (single, double), the reported scores are always computed in the storage precision", cxxopts::value<std::string>())
+        ("simplify", "Simplify the trees before scoring them (see Tree::Simplify) and the reported best model", cxxopts::value<bool>()->default_value("false"))
+        ("interval-prescreening", "Reject the models whose output is not bounded over the ranges of the input variables before scoring them", cxxopts::value<bool>()->default_value("false"))
+        ("sample-size", "Score the models on a random sample of this many training rows, redrawn each generation (0 for the whole training range)", cxxopts::value<size_t>()->default_value("0"))
+        ("sample-growth", "Grow the sample linearly up to the whole training range over the generations", cxxopts::value<bool>()->default_value("false"))
         ("show-primitives", "Display the primitive set used by the algorithm")
         ("threads", "Number of threads to use for parallelism", cxxopts::value<size_t>()->default_value("0"))
         ("debug", "Debug mode (more information displayed)")
@@ -225,6 +249,17 @@ int main(int argc, char** argv)
         }
         auto problem = Problem(*dataset).Inputs(inputs).Target(target).TrainingRange(trainingRange).TestRange(testRange);
         problem.GetPrimitiveSet().SetConfig(primitiveSetConfig);
+        if (result.count("precision") > 0) {
+            auto value = result["precision"].as<std::string>();
+            if (value == "single") {
+                problem.SetPrecision(Precision::Single);
+            } else if (value == "double") {
+                problem.SetPrecision(Precision::Double);
+            } else {
+                fmt::print(stderr, "{}\n{}\n", "Error: unknown precision (expected single or double).", opts.help());
+                exit(EXIT_FAILURE);
+            }
+        }
         // set symbol arities
         for (auto t : { NodeType::Add, NodeType::Sub, NodeType::Mul, NodeType::Div }) {
             problem.GetPrimitiveSet().SetMaximumArity(t, 2);
@@ -288,6 +323,20 @@ int main(int argc, char** argv)
         //MeanSquaredErrorEvaluator evaluator(problem);
         evaluator.SetLocalOptimizationIterations(config.Iterations);
         evaluator.SetBudget(config.Evaluations);
+        evaluator.SetSimplification(result["simplify"].as<bool>());
+        evaluator.SetIntervalPrescreening(result["interval-prescreening"].as<bool>());
+
+        if (auto sampleSize = result["sample-size"].as<size_t>(); sampleSize > 0) {
+            if (result["sample-growth"].as<bool>()) {
+                auto rows = problem.TrainingRange().Size();
+                auto generations = std::max(config.Generations, size_t { 1 });
+                evaluator.SetSampleSchedule([=](size_t generation) {
+                    return sampleSize + (rows - std::min(sampleSize, rows)) * std::min(generation, generations) / generations;
+                });
+            } else {
+                evaluator.SetSampleSize(sampleSize);
+            }
+        }
 
         EXPECT(problem.TrainingRange().Size() > 0);
 
@@ -342,14 +391,21 @@ int main(int argc, char** argv)
         femaleSelector.reset(parseSelector("female-selector"));
         maleSelector.reset(parseSelector("male-selector"));
 
+        // the basic generator does not need the offspring fitness, so the offspring can be evaluated in batch
+        auto makeBasicGenerator = [&]() {
+            auto ptr = new BasicOffspringGenerator(evaluator, crossover, mutator, *femaleSelector, *maleSelector);
+            ptr->SetDeferredEvaluation(result["deferred-evaluation"].as<bool>());
+            return ptr;
+        };
+
         std::unique_ptr<OffspringGenerator> generator;
         if (result.count("offspring-generator") == 0) {
-            generator.reset(new BasicOffspringGenerator(evaluator, crossover, mutator, *femaleSelector, *maleSelector));
+            generator.reset(makeBasicGenerator());
         } else {
             auto value = result["offspring-generator"].as<std::string>();
             auto tokens = Split(value, ':');
             if (tokens[0] == "basic") {
-                generator.reset(new BasicOffspringGenerator(evaluator, crossover, mutator, *femaleSelector, *maleSelector));
+                generator.reset(makeBasicGenerator());
             } else if (tokens[0] == "brood") {
                 size_t broodSize = 10;
                 if (tokens.size() > 1) {
@@ -437,12 +493,17 @@ int main(int argc, char** argv)
         auto report = [&]() {
             auto const& pop = gp.Parents();
             best = getBest(pop);
+            if (evaluator.GetSimplification()) {
+                best.Genotype.Simplify();
+            }
 
             //fmt::print("best: {}\n", InfixFormatter::Format(best.Genotype, *dataset));
 
+            // the best model is evaluated outside of the population loop, so large ranges are split over the threads
             auto batchSize = 100ul;
-            auto estimatedTrain = Evaluate<Operon::Scalar>(best.Genotype, *dataset, trainingRange, batchSize);
-            auto estimatedTest = Evaluate<Operon::Scalar>(best.Genotype, *dataset, testRange, batchSize);
+            auto parallel = true;
+            auto estimatedTrain = Evaluate<Operon::Scalar>(best.Genotype, *dataset, trainingRange, batchSize, nullptr, parallel);
+            auto estimatedTest = Evaluate<Operon::Scalar>(best.Genotype, *dataset, testRange, batchSize, nullptr, parallel);
 
             // scale values
             auto [a, b] = LinearScalingCalculator::Calculate(estimatedTrain.begin(), estimatedTrain.end(), targetTrain.begin());
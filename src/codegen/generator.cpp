@@ -0,0 +1,485 @@
+/* This file is part of:
+ * Operon - Large Scale Genetic Programming Framework
+ *
+ * Licensed under the ISC License <https://opensource.org/licenses/ISC>
+ * Copyright (C) 2020 Bogdan Burlacu
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+ * REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+ * INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+ * LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+ * OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+ * PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include "codegen/generator.hpp"
+
+#include <list>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+
+#include <llvm/ExecutionEngine/Orc/CompileUtils.h>
+#include <llvm/ExecutionEngine/Orc/ExecutionUtils.h>
+#include <llvm/ExecutionEngine/Orc/LLJIT.h>
+#include <llvm/ExecutionEngine/Orc/ThreadSafeModule.h>
+#include <llvm/IR/IRBuilder.h>
+#include <llvm/IR/Intrinsics.h>
+#include <llvm/IR/LLVMContext.h>
+#include <llvm/IR/Module.h>
+#include <llvm/IR/Verifier.h>
+#include <llvm/Passes/PassBuilder.h>
+#include <llvm/Support/TargetSelect.h>
+#include <llvm/Target/TargetMachine.h>
+
+#include "core/constants.hpp"
+
+namespace Operon {
+
+namespace {
+    // postfix order in which the children of commutative nodes are sorted in the same way as in Tree::Hash,
+    // so that all the trees sharing a hash value also share the same canonical node order
+    void CanonicalOrder(Tree const& tree, size_t i, std::vector<size_t>& order)
+    {
+        auto const& nodes = tree.Nodes();
+        auto const& n = nodes[i];
+
+        if (n.IsLeaf()) {
+            order.push_back(i);
+            return;
+        }
+
+        std::vector<size_t> children;
+        children.reserve(n.Arity);
+        for (auto it = tree.Children(i); it.HasNext(); ++it) {
+            children.push_back(it.Index());
+        }
+        if (n.IsCommutative()) {
+            std::stable_sort(children.begin(), children.end(), [&](auto a, auto b) { return nodes[a] < nodes[b]; });
+        }
+        // the first child is emitted last, to preserve the postfix layout for non-commutative nodes
+        for (auto it = children.rbegin(); it != children.rend(); ++it) {
+            CanonicalOrder(tree, *it, order);
+        }
+        order.push_back(i);
+    }
+
+    std::vector<size_t> CanonicalOrder(Tree const& tree)
+    {
+        std::vector<size_t> order;
+        order.reserve(tree.Length());
+        CanonicalOrder(tree, tree.Length() - 1, order);
+        return order;
+    }
+
+    void Optimize(llvm::Module& module, llvm::TargetMachine* tm)
+    {
+        llvm::LoopAnalysisManager lam;
+        llvm::FunctionAnalysisManager fam;
+        llvm::CGSCCAnalysisManager cgam;
+        llvm::ModuleAnalysisManager mam;
+
+        llvm::PassBuilder pb(tm);
+        pb.registerModuleAnalyses(mam);
+        pb.registerCGSCCAnalyses(cgam);
+        pb.registerFunctionAnalyses(fam);
+        pb.registerLoopAnalyses(lam);
+        pb.crossRegisterProxies(lam, fam, cgam, mam);
+
+        auto mpm = pb.buildPerModuleDefaultPipeline(llvm::OptimizationLevel::O3);
+        mpm.run(module, mam);
+    }
+} // namespace
+
+struct CodeGen::Impl {
+    std::unique_ptr<llvm::TargetMachine> targetMachine;
+    std::unique_ptr<llvm::orc::LLJIT> jit;
+
+    struct Entry {
+        Function function;
+        llvm::orc::ResourceTrackerSP tracker;
+        std::list<Operon::Hash>::iterator position;
+    };
+
+    std::unordered_map<Operon::Hash, Entry> cache;
+    std::list<Operon::Hash> recent; // most recently used at the front
+    size_t capacity;
+    size_t hits = 0;
+    size_t misses = 0;
+    size_t count = 0; // number of compiled functions (used to generate unique names)
+    mutable std::mutex mutex; // guards the cache and the counters, the functions are compiled outside of it
+
+    // evicted code is only released when no compiled function is running
+    std::vector<llvm::orc::ResourceTrackerSP> evicted;
+    size_t running = 0;
+
+    // returns the compiled function and increments the number of running functions
+    Function Acquire(Tree const& tree, std::vector<size_t> const& order);
+    void Release();
+    Function Compile(Tree const& tree, std::vector<size_t> const& order, std::string const& name, llvm::orc::ResourceTrackerSP tracker);
+};
+
+CodeGen::CodeGen(size_t capacity)
+    : impl(std::make_unique<Impl>())
+{
+    static std::once_flag initialized;
+    std::call_once(initialized, []() {
+        llvm::InitializeNativeTarget();
+        llvm::InitializeNativeTargetAsmPrinter();
+    });
+
+    impl->capacity = std::max(capacity, size_t { 1 });
+
+    auto jtmb = llvm::orc::JITTargetMachineBuilder::detectHost();
+    if (!jtmb) {
+        throw std::runtime_error(llvm::toString(jtmb.takeError()));
+    }
+    jtmb->setCodeGenOptLevel(llvm::CodeGenOpt::Aggressive);
+
+    auto tm = jtmb->createTargetMachine();
+    if (!tm) {
+        throw std::runtime_error(llvm::toString(tm.takeError()));
+    }
+    impl->targetMachine = std::move(*tm);
+
+    // the modules are compiled concurrently by the threads missing the cache, each with its own target machine
+    llvm::orc::LLJITBuilder builder;
+    builder.setJITTargetMachineBuilder(*jtmb).setCompileFunctionCreator([](llvm::orc::JITTargetMachineBuilder machineBuilder) -> llvm::Expected<std::unique_ptr<llvm::orc::IRCompileLayer::IRCompiler>> {
+        return std::make_unique<llvm::orc::ConcurrentIRCompiler>(std::move(machineBuilder));
+    });
+    auto jit = builder.create();
+    if (!jit) {
+        throw std::runtime_error(llvm::toString(jit.takeError()));
+    }
+    impl->jit = std::move(*jit);
+
+    // math functions without an intrinsic (eg. tan, cbrt) are resolved from the current process
+    auto generator = llvm::orc::DynamicLibrarySearchGenerator::GetForCurrentProcess(impl->jit->getDataLayout().getGlobalPrefix());
+    if (!generator) {
+        throw std::runtime_error(llvm::toString(generator.takeError()));
+    }
+    impl->jit->getMainJITDylib().addGenerator(std::move(*generator));
+
+    impl->jit->getIRTransformLayer().setTransform([machineBuilder = *jtmb](llvm::orc::ThreadSafeModule tsm, llvm::orc::MaterializationResponsibility const&) -> llvm::Expected<llvm::orc::ThreadSafeModule> {
+        auto tm = llvm::orc::JITTargetMachineBuilder(machineBuilder).createTargetMachine();
+        if (!tm) {
+            return tm.takeError();
+        }
+        tsm.withModuleDo([&](llvm::Module& m) { Optimize(m, tm->get()); });
+        return tsm;
+    });
+}
+
+CodeGen::~CodeGen() = default;
+
+CodeGen& CodeGen::Instance()
+{
+    static CodeGen instance;
+    return instance;
+}
+
+size_t CodeGen::CacheSize() const
+{
+    std::lock_guard<std::mutex> lock(impl->mutex);
+    return impl->cache.size();
+}
+
+size_t CodeGen::CacheCapacity() const { return impl->capacity; }
+
+size_t CodeGen::CacheHits() const
+{
+    std::lock_guard<std::mutex> lock(impl->mutex);
+    return impl->hits;
+}
+
+size_t CodeGen::CacheMisses() const
+{
+    std::lock_guard<std::mutex> lock(impl->mutex);
+    return impl->misses;
+}
+
+CodeGen::Function CodeGen::Impl::Acquire(Tree const& tree, std::vector<size_t> const& order)
+{
+    auto key = tree.HashValue();
+    auto lookup = [&]() -> Function {
+        if (auto it = cache.find(key); it != cache.end()) {
+            ++running;
+            recent.splice(recent.begin(), recent, it->second.position);
+            return it->second.function;
+        }
+        return nullptr;
+    };
+
+    std::string name;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (auto function = lookup(); function != nullptr) {
+            ++hits;
+            return function;
+        }
+        ++misses;
+        name = "expr" + std::to_string(count++);
+    }
+
+    // the optimization and the native code generation dominate the cost of a miss, so they do not hold the lock
+    auto tracker = jit->getMainJITDylib().createResourceTracker();
+    auto function = Compile(tree, order, name, tracker);
+    if (function == nullptr) {
+        if (auto err = tracker->remove()) {
+            llvm::consumeError(std::move(err));
+        }
+        return nullptr;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    // another thread compiled the same tree in the meantime: its function is used and this one is released with the evicted code
+    if (auto cached = lookup(); cached != nullptr) {
+        evicted.push_back(std::move(tracker));
+        return cached;
+    }
+    // the least recently used function is only evicted once its replacement is compiled
+    if (cache.size() >= capacity) {
+        auto it = cache.find(recent.back());
+        evicted.push_back(std::move(it->second.tracker));
+        cache.erase(it);
+        recent.pop_back();
+    }
+    ++running;
+    recent.push_front(key);
+    cache.insert({ key, Entry { function, tracker, recent.begin() } });
+    return function;
+}
+
+void CodeGen::Impl::Release()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    if (--running > 0) {
+        return;
+    }
+    for (auto& tracker : evicted) {
+        if (auto err = tracker->remove()) {
+            llvm::consumeError(std::move(err));
+        }
+    }
+    evicted.clear();
+}
+
+CodeGen::Function CodeGen::Impl::Compile(Tree const& tree, std::vector<size_t> const& order, std::string const& name, llvm::orc::ResourceTrackerSP tracker)
+{
+    auto context = std::make_unique<llvm::LLVMContext>();
+    auto module = std::make_unique<llvm::Module>("codegen", *context);
+    module->setDataLayout(jit->getDataLayout());
+    module->setTargetTriple(targetMachine->getTargetTriple().str());
+
+    llvm::IRBuilder<> builder(*context);
+    auto scalarTy = std::is_same_v<Operon::Scalar, float> ? builder.getFloatTy() : builder.getDoubleTy();
+    auto scalarPtrTy = scalarTy->getPointerTo();
+    auto indexTy = builder.getInt64Ty();
+
+    // void f(Scalar const* coefficients, Scalar const* const* columns, uint64_t start, uint64_t count, Scalar* result)
+    auto functionTy = llvm::FunctionType::get(builder.getVoidTy(), { scalarPtrTy, scalarPtrTy->getPointerTo(), indexTy, indexTy, scalarPtrTy }, /* is var arg */ false);
+    auto function = llvm::Function::Create(functionTy, llvm::Function::ExternalLinkage, name, module.get());
+    function->addFnAttr("target-cpu", targetMachine->getTargetCPU());
+    function->addFnAttr("target-features", targetMachine->getTargetFeatureString());
+    function->addFnAttr(llvm::Attribute::NoUnwind);
+    for (unsigned i : { 0u, 1u, 4u }) {
+        function->addParamAttr(i, llvm::Attribute::NoAlias);
+    }
+
+    auto args = function->arg_begin();
+    llvm::Value* coefficients = args++;
+    llvm::Value* columns = args++;
+    llvm::Value* start = args++;
+    llvm::Value* rows = args++;
+    llvm::Value* result = args++;
+
+    auto tanFunc = module->getOrInsertFunction(std::is_same_v<Operon::Scalar, float> ? "tanf" : "tan", scalarTy, scalarTy);
+    auto cbrtFunc = module->getOrInsertFunction(std::is_same_v<Operon::Scalar, float> ? "cbrtf" : "cbrt", scalarTy, scalarTy);
+
+    auto entry = llvm::BasicBlock::Create(*context, "entry", function);
+    auto loop = llvm::BasicBlock::Create(*context, "loop", function);
+    auto exit = llvm::BasicBlock::Create(*context, "exit", function);
+
+    // load the coefficients and column pointers (offset by the start row) once, outside the loop
+    auto const& nodes = tree.Nodes();
+    std::vector<llvm::Value*> coeff(nodes.size(), nullptr);
+    std::vector<llvm::Value*> data(nodes.size(), nullptr);
+
+    builder.SetInsertPoint(entry);
+    size_t leaf = 0;
+    for (auto i : order) {
+        if (!nodes[i].IsLeaf()) {
+            continue;
+        }
+        auto k = builder.getInt64(leaf++);
+        coeff[i] = builder.CreateLoad(scalarTy, builder.CreateInBoundsGEP(scalarTy, coefficients, k));
+        if (nodes[i].IsVariable()) {
+            auto column = builder.CreateLoad(scalarPtrTy, builder.CreateInBoundsGEP(scalarPtrTy, columns, k));
+            data[i] = builder.CreateInBoundsGEP(scalarTy, column, start);
+        }
+    }
+    builder.CreateCondBr(builder.CreateICmpEQ(rows, builder.getInt64(0)), exit, loop);
+
+    builder.SetInsertPoint(loop);
+    auto row = builder.CreatePHI(indexTy, 2);
+    row->addIncoming(builder.getInt64(0), entry);
+
+    std::vector<llvm::Value*> values(nodes.size(), nullptr);
+    for (auto i : order) {
+        auto const& n = nodes[i];
+
+        if (n.IsLeaf()) {
+            values[i] = n.IsVariable()
+                ? builder.CreateFMul(coeff[i], builder.CreateLoad(scalarTy, builder.CreateInBoundsGEP(scalarTy, data[i], row)))
+                : coeff[i];
+            continue;
+        }
+
+        std::vector<llvm::Value*> operands;
+        operands.reserve(n.Arity);
+        for (auto it = tree.Children(i); it.HasNext(); ++it) {
+            operands.push_back(values[it.Index()]);
+        }
+        auto first = operands.front();
+
+        // n-ary semantics follow the interpreter: a - (b + c + ...) and a / (b * c * ...)
+        auto fold = [&](auto&& op) {
+            auto acc = operands[1];
+            for (size_t k = 2; k < operands.size(); ++k) {
+                acc = op(acc, operands[k]);
+            }
+            return acc;
+        };
+        auto add = [&](llvm::Value* a, llvm::Value* b) { return builder.CreateFAdd(a, b); };
+        auto mul = [&](llvm::Value* a, llvm::Value* b) { return builder.CreateFMul(a, b); };
+
+        switch (n.Type) {
+        case NodeType::Add: {
+            values[i] = operands.size() == 1 ? first : builder.CreateFAdd(first, fold(add));
+            break;
+        }
+        case NodeType::Sub: {
+            values[i] = operands.size() == 1 ? builder.CreateFNeg(first) : builder.CreateFSub(first, fold(add));
+            break;
+        }
+        case NodeType::Mul: {
+            values[i] = operands.size() == 1 ? first : builder.CreateFMul(first, fold(mul));
+            break;
+        }
+        case NodeType::Div: {
+            values[i] = operands.size() == 1 ? builder.CreateFDiv(llvm::ConstantFP::get(scalarTy, 1.0), first) : builder.CreateFDiv(first, fold(mul));
+            break;
+        }
+        case NodeType::Exp: {
+            values[i] = builder.CreateUnaryIntrinsic(llvm::Intrinsic::exp, first);
+            break;
+        }
+        case NodeType::Log: {
+            values[i] = builder.CreateUnaryIntrinsic(llvm::Intrinsic::log, first);
+            break;
+        }
+        case NodeType::Sin: {
+            values[i] = builder.CreateUnaryIntrinsic(llvm::Intrinsic::sin, first);
+            break;
+        }
+        case NodeType::Cos: {
+            values[i] = builder.CreateUnaryIntrinsic(llvm::Intrinsic::cos, first);
+            break;
+        }
+        case NodeType::Tan: {
+            values[i] = builder.CreateCall(tanFunc, { first });
+            break;
+        }
+        case NodeType::Sqrt: {
+            values[i] = builder.CreateUnaryIntrinsic(llvm::Intrinsic::sqrt, first);
+            break;
+        }
+        case NodeType::Cbrt: {
+            values[i] = builder.CreateCall(cbrtFunc, { first });
+            break;
+        }
+        case NodeType::Square: {
+            values[i] = builder.CreateFMul(first, first);
+            break;
+        }
+        default: {
+            return nullptr;
+        }
+        }
+    }
+
+    // non-finite values are replaced with Numeric::Max, like in the interpreter
+    auto value = values[order.back()];
+    auto isFinite = builder.CreateFCmpOLT(builder.CreateUnaryIntrinsic(llvm::Intrinsic::fabs, value), llvm::ConstantFP::getInfinity(scalarTy));
+    value = builder.CreateSelect(isFinite, value, llvm::ConstantFP::get(scalarTy, Operon::Numeric::Max<Operon::Scalar>()));
+    builder.CreateStore(value, builder.CreateInBoundsGEP(scalarTy, result, row));
+
+    auto next = builder.CreateAdd(row, builder.getInt64(1));
+    row->addIncoming(next, loop);
+    builder.CreateCondBr(builder.CreateICmpULT(next, rows), loop, exit);
+
+    builder.SetInsertPoint(exit);
+    builder.CreateRetVoid();
+
+    if (llvm::verifyFunction(*function)) {
+        return nullptr;
+    }
+
+    if (auto err = jit->addIRModule(tracker, llvm::orc::ThreadSafeModule(std::move(module), std::move(context)))) {
+        llvm::consumeError(std::move(err));
+        return nullptr;
+    }
+
+    auto symbol = jit->lookup(name);
+    if (!symbol) {
+        llvm::consumeError(symbol.takeError());
+        return nullptr;
+    }
+    return llvm::jitTargetAddressToFunction<Function>(symbol->getAddress());
+}
+
+bool CodeGen::Evaluate(Tree const& tree, Dataset const& dataset, Range range, gsl::span<Operon::Scalar> result, Operon::Scalar const* parameters)
+{
+    EXPECT(result.size() >= range.Size());
+
+    // the cache key and the canonical order are both based on the relaxed hash (which ignores coefficient values)
+    auto hashed = tree;
+    hashed.Hash<Operon::HashFunction::XXHash>(Operon::HashMode::Relaxed);
+    auto order = CanonicalOrder(hashed);
+
+    auto function = impl->Acquire(hashed, order);
+    if (function == nullptr) {
+        return false;
+    }
+
+    // the parameters are indexed by the postfix position of the leaf in the original tree
+    auto const& nodes = tree.Nodes();
+    std::vector<size_t> leafIndex(nodes.size());
+    for (size_t i = 0, k = 0; i < nodes.size(); ++i) {
+        if (nodes[i].IsLeaf()) {
+            leafIndex[i] = k++;
+        }
+    }
+
+    std::vector<Operon::Scalar> coefficients;
+    std::vector<Operon::Scalar const*> columns;
+    for (auto i : order) {
+        auto const& n = nodes[i];
+        if (!n.IsLeaf()) {
+            continue;
+        }
+        coefficients.push_back(parameters ? parameters[leafIndex[i]] : n.Value);
+        columns.push_back(n.IsVariable() ? dataset.GetValues(n.HashValue).data() : nullptr);
+    }
+
+    function(coefficients.data(), columns.data(), range.Start(), range.Size(), result.data());
+    impl->Release();
+    return true;
+}
+} // namespace Operon
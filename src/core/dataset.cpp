@@ -18,12 +18,29 @@
  */
 
 #include "core/dataset.hpp"
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <cmath>
+#include <cstring>
 #include <fmt/core.h>
+#include <fstream>
+#include <limits>
+#include <numeric>
+#include <string_view>
+#include <tbb/parallel_for.h>
+#include <thread>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 
 #include "core/constants.hpp"
 #include "core/types.hpp"
 #include "hash/hash.hpp"
-#include <rapidcsv.h>
 
 namespace Operon {
 
@@ -42,40 +59,349 @@ namespace {
         std::sort(vars.begin(), vars.end(), [](auto &a, auto &b) { return a.Hash < b.Hash; });
         return vars;
     };
+
+    // binary format (see Dataset::WriteBinary)
+    constexpr std::array<char, 8> BinaryMagic { 'O', 'P', 'E', 'R', 'O', 'N', 'D', 'S' };
+    constexpr uint32_t BinaryVersion = 1;
+    constexpr uint64_t BinaryAlignment = 64;
+
+    struct BinaryHeader {
+        std::array<char, 8> Magic;
+        uint32_t Version;
+        uint32_t ScalarSize;
+        uint64_t Rows;
+        uint64_t Cols;
+        uint64_t DataOffset; // offset of the values from the start of the file
+    };
+
+    // map the whole file read-only into memory (or read it where mmap is not available)
+    std::pair<std::shared_ptr<void const>, size_t> MapFile(std::string const& path)
+    {
+#if defined(__unix__) || defined(__APPLE__)
+        auto fd = ::open(path.c_str(), O_RDONLY); // NOLINT
+        if (fd < 0) {
+            throw std::runtime_error(fmt::format("Cannot open {}.\n", path));
+        }
+        struct stat st { };
+        if (::fstat(fd, &st) != 0 || st.st_size == 0) {
+            ::close(fd);
+            throw std::runtime_error(fmt::format("Cannot map {}.\n", path));
+        }
+        auto size = static_cast<size_t>(st.st_size);
+        auto* addr = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd); // the mapping keeps a reference to the file
+        if (addr == MAP_FAILED) { // NOLINT
+            throw std::runtime_error(fmt::format("Cannot map {}.\n", path));
+        }
+        return { std::shared_ptr<void const>(addr, [size](void const* p) { ::munmap(const_cast<void*>(p), size); }), size };
+#else
+        std::ifstream in(path, std::ios::binary | std::ios::ate);
+        if (!in) {
+            throw std::runtime_error(fmt::format("Cannot open {}.\n", path));
+        }
+        auto size = static_cast<size_t>(in.tellg());
+        auto buffer = std::make_shared<std::vector<char>>(size);
+        in.seekg(0);
+        in.read(buffer->data(), static_cast<std::streamsize>(size));
+        return { std::shared_ptr<void const>(buffer, buffer->data()), size };
+#endif
+    }
+
+    // csv files are split at line boundaries into chunks of at least this size, parsed in parallel
+    constexpr size_t CsvChunkSize = 1UL << 16;
+
+    std::string_view Trim(std::string_view s)
+    {
+        constexpr char const* blanks = " \t\r";
+        auto begin = s.find_first_not_of(blanks);
+        if (begin == std::string_view::npos) {
+            return {};
+        }
+        return s.substr(begin, s.find_last_not_of(blanks) - begin + 1);
+    }
+
+    // remove and return the first comma-separated field of a line
+    std::string_view NextField(std::string_view& line)
+    {
+        auto p = line.find(',');
+        auto field = line.substr(0, p);
+        line = p == std::string_view::npos ? std::string_view {} : line.substr(p + 1);
+        return field;
+    }
+
+    // split the header line into the column names: a name may be quoted (eg. "x, y"), with "" standing for a quote
+    std::vector<std::string> ParseHeader(std::string_view line, std::string const& path)
+    {
+        std::vector<std::string> names;
+        bool last = false;
+        auto next = [&]() {
+            last = line.find(',') == std::string_view::npos;
+            return NextField(line);
+        };
+        while (!last) {
+            auto field = next();
+            auto name = Trim(field);
+            if (name.empty() || name.front() != '"') {
+                names.emplace_back(name);
+                continue;
+            }
+            // the name ends at the closing quote, the commas between the quotes belong to it
+            std::string quoted;
+            auto rest = field.substr(field.find('"') + 1);
+            while (true) {
+                auto p = rest.find('"');
+                if (p == std::string_view::npos) {
+                    if (last) {
+                        throw std::runtime_error(fmt::format("{}: unterminated quoted column name in the header.\n", path));
+                    }
+                    quoted.append(rest).push_back(',');
+                    rest = next();
+                    continue;
+                }
+                quoted.append(rest.substr(0, p));
+                rest.remove_prefix(p + 1);
+                if (rest.empty() || rest.front() != '"') {
+                    break;
+                }
+                quoted.push_back('"');
+                rest.remove_prefix(1);
+            }
+            if (!Trim(rest).empty()) {
+                throw std::runtime_error(fmt::format("{}: unexpected characters after the quoted column name '{}' in the header.\n", path, quoted));
+            }
+            names.push_back(std::move(quoted));
+        }
+        return names;
+    }
+
+    // call f on each non-blank line of the text and return their number
+    template <typename F>
+    size_t ForEachLine(std::string_view text, F&& f)
+    {
+        size_t count = 0;
+        while (!text.empty()) {
+            auto p = text.find('\n');
+            auto line = text.substr(0, p);
+            text = p == std::string_view::npos ? std::string_view {} : text.substr(p + 1);
+            if (!line.empty() && line.back() == '\r') {
+                line.remove_suffix(1);
+            }
+            if (Trim(line).empty()) {
+                continue;
+            }
+            f(line, count++);
+        }
+        return count;
+    }
+
+    // blanks around the number and a leading + are accepted, an empty field is a missing value (nan)
+    Operon::Scalar ParseValue(std::string_view field, size_t row, size_t col)
+    {
+        auto s = Trim(field);
+        if (s.empty()) {
+            return std::numeric_limits<Operon::Scalar>::quiet_NaN();
+        }
+        if (s.front() == '+') {
+            s.remove_prefix(1);
+        }
+        Operon::Scalar value {};
+        auto [p, ec] = std::from_chars(s.data(), s.data() + s.size(), value);
+        if (ec != std::errc() || p != s.data() + s.size()) {
+            throw std::runtime_error(fmt::format("Cannot convert '{}' (row {}, column {}) to a number.\n", field, row, col));
+        }
+        return value;
+    }
+} // namespace
+
+bool Dataset::IsBinary(std::string const& path)
+{
+    std::array<char, BinaryMagic.size()> magic {};
+    std::ifstream in(path, std::ios::binary);
+    return in.read(magic.data(), magic.size()) && magic == BinaryMagic;
+}
+
+void Dataset::WriteBinary(std::string const& path) const
+{
+    std::ofstream out(path, std::ios::binary);
+    if (!out) {
+        throw std::runtime_error(fmt::format("Cannot open {} for writing.\n", path));
+    }
+    auto write = [&](auto const& value) { out.write(reinterpret_cast<char const*>(&value), sizeof(value)); };
+
+    // the variables in column order
+    std::vector<Variable> columns(variables);
+    std::sort(columns.begin(), columns.end(), [](auto const& a, auto const& b) { return a.Index < b.Index; });
+
+    auto offset = uint64_t { sizeof(BinaryHeader) };
+    for (auto const& v : columns) {
+        offset += sizeof(uint64_t) + 2 * sizeof(double) + sizeof(uint64_t) + v.Name.size();
+    }
+    offset = (offset + BinaryAlignment - 1) / BinaryAlignment * BinaryAlignment;
+
+    BinaryHeader header { BinaryMagic, BinaryVersion, sizeof(Operon::Scalar), Rows(), Cols(), offset };
+    write(header);
+    for (auto const& v : columns) {
+        auto const& b = bounds[v.Index];
+        write(uint64_t { v.Hash });
+        write(b.Lower);
+        write(b.Upper);
+        write(uint64_t { v.Name.size() });
+        out.write(v.Name.data(), static_cast<std::streamsize>(v.Name.size()));
+    }
+    std::vector<char> padding(offset - static_cast<uint64_t>(out.tellp()), 0);
+    out.write(padding.data(), static_cast<std::streamsize>(padding.size()));
+
+    for (Eigen::Index i = 0; i < map.cols(); ++i) {
+        out.write(reinterpret_cast<char const*>(Column(i).data()), static_cast<std::streamsize>(map.rows() * Eigen::Index { sizeof(Operon::Scalar) }));
+    }
+    if (!out) {
+        throw std::runtime_error(fmt::format("Cannot write {}.\n", path));
+    }
+}
+
+Dataset::Map Dataset::ReadBinary(std::string const& path)
+{
+    auto [data, size] = MapFile(path);
+    auto const* bytes = static_cast<char const*>(data.get());
+    auto invalid = [&]() { return std::runtime_error(fmt::format("{} is not a valid dataset file.\n", path)); };
+
+    BinaryHeader header {};
+    if (size < sizeof(header)) {
+        throw invalid();
+    }
+    std::memcpy(&header, bytes, sizeof(header));
+    if (header.Magic != BinaryMagic) {
+        throw invalid();
+    }
+    if (header.Version != BinaryVersion) {
+        throw std::runtime_error(fmt::format("{}: unsupported dataset format version {} (expected {}).\n", path, header.Version, BinaryVersion));
+    }
+    if (header.ScalarSize != sizeof(Operon::Scalar)) {
+        throw std::runtime_error(fmt::format("{}: the values are stored with {} bytes, this build uses {}.\n", path, header.ScalarSize, sizeof(Operon::Scalar)));
+    }
+    if (header.DataOffset > size || (size - header.DataOffset) / sizeof(Operon::Scalar) / std::max(header.Cols, uint64_t { 1 }) < header.Rows) {
+        throw invalid();
+    }
+
+    size_t pos = sizeof(header);
+    auto read = [&](auto& value) {
+        if (pos + sizeof(value) > header.DataOffset) {
+            throw invalid();
+        }
+        std::memcpy(&value, bytes + pos, sizeof(value));
+        pos += sizeof(value);
+    };
+    variables.resize(header.Cols);
+    bounds.resize(header.Cols);
+    for (size_t i = 0; i < header.Cols; ++i) {
+        uint64_t hash {};
+        uint64_t length {};
+        read(hash);
+        read(bounds[i].Lower);
+        read(bounds[i].Upper);
+        read(length);
+        if (length > header.DataOffset - pos) {
+            throw invalid();
+        }
+        variables[i] = Variable { std::string(bytes + pos, length), hash, i };
+        pos += length;
+    }
+    std::sort(variables.begin(), variables.end(), [](auto& a, auto& b) { return a.Hash < b.Hash; });
+
+    mapping = std::move(data);
+    chunkSize = std::max(DefaultChunkBytes / (std::max(static_cast<size_t>(header.Cols), size_t { 1 }) * sizeof(Operon::Scalar)), size_t { 1 });
+    return Map(reinterpret_cast<Operon::Scalar const*>(bytes + header.DataOffset), static_cast<Eigen::Index>(header.Rows), static_cast<Eigen::Index>(header.Cols));
+}
+
+void Dataset::Prefetch(Range range) const noexcept
+{
+#if defined(__unix__) || defined(__APPLE__)
+    auto end = std::min(range.End(), Rows());
+    if (!mapping || range.Start() >= end) {
+        return;
+    }
+    auto page = static_cast<uintptr_t>(::sysconf(_SC_PAGESIZE));
+    for (Eigen::Index i = 0; i < map.cols(); ++i) {
+        auto const* col = Column(i).data();
+        auto first = reinterpret_cast<uintptr_t>(col + range.Start()) / page * page; // the mapping starts on a page
+        auto last = reinterpret_cast<uintptr_t>(col + end);
+        ::madvise(reinterpret_cast<void*>(first), last - first, MADV_WILLNEED); // NOLINT
+    }
+#else
+    (void)range;
+#endif
 }
 
 Dataset::Map Dataset::ReadCsv(std::string const& path, bool hasHeader)
 {
-    rapidcsv::Document doc(path, rapidcsv::LabelParams(hasHeader-1, -1));
+    std::ifstream in(path, std::ios::binary | std::ios::ate);
+    if (!in) {
+        throw std::runtime_error(fmt::format("Cannot open {}.\n", path));
+    }
+    std::string text(static_cast<size_t>(in.tellg()), '\0');
+    in.seekg(0);
+    in.read(text.data(), static_cast<std::streamsize>(text.size()));
+    std::string_view buffer(text);
 
-    // get row and column count
-    size_t nrow = doc.GetRowCount();
-    size_t ncol = doc.GetColumnCount();
+    // the first line gives the number of columns and, with a header, their names
+    auto eol = std::min(buffer.find('\n'), buffer.size());
+    auto first = buffer.substr(0, eol);
+    if (Trim(first).empty()) {
+        throw std::runtime_error(fmt::format("{} does not start with a row of values or a header.\n", path));
+    }
+    size_t ncol = static_cast<size_t>(std::count(first.begin(), first.end(), ',')) + 1;
 
     // fix column names and initialize the variables
-    // allocate and fill in values
     if (hasHeader) {
-        auto names = doc.GetColumnNames();
-
         Hasher<HashFunction::XXHash> hash;
 
+        auto names = ParseHeader(first, path);
+        ncol = names.size();
         variables.resize(ncol);
         for (size_t i = 0; i < ncol; ++i) {
-            auto h = hash(reinterpret_cast<uint8_t const*>(names[i].c_str()), names[i].size());
-            Variable v { names[i], h, i };
-            variables[i] = v;
+            auto const& name = names[i];
+            auto h = hash(reinterpret_cast<uint8_t const*>(name.c_str()), name.size());
+            variables[i] = Variable { name, h, i };
         }
         std::sort(variables.begin(), variables.end(), [](auto& a, auto& b) { return a.Hash < b.Hash; });
+        buffer.remove_prefix(std::min(eol + 1, buffer.size()));
     } else {
         variables = defaultVariables(ncol);
     }
-    values = Matrix(nrow, ncol);
-    for (size_t i = 0; i < ncol; ++i) {
-        auto col = values.col((Eigen::Index)i);
-        for (size_t j = 0; j < nrow; ++j) {
-            col((Eigen::Index)j) = doc.GetCell<Operon::Scalar>(i, j);
-        }
+
+    // split the values at line boundaries into chunks: the lines of each chunk are counted first to find the
+    // row of its first line, then each chunk is parsed directly into the columns of the matrix
+    auto threads = std::max(size_t { std::thread::hardware_concurrency() }, size_t { 1 });
+    auto nchunk = std::clamp(buffer.size() / CsvChunkSize, size_t { 1 }, 4 * threads);
+    std::vector<size_t> offsets(nchunk + 1, buffer.size());
+    offsets[0] = 0;
+    for (size_t k = 1; k < nchunk; ++k) {
+        auto p = buffer.find('\n', std::max(k * buffer.size() / nchunk, offsets[k - 1]));
+        offsets[k] = p == std::string_view::npos ? buffer.size() : p + 1;
     }
+    auto chunk = [&](size_t k) { return buffer.substr(offsets[k], offsets[k + 1] - offsets[k]); };
+
+    std::vector<size_t> rows(nchunk + 1, 0);
+    tbb::parallel_for(size_t { 0 }, nchunk, [&](size_t k) {
+        rows[k + 1] = ForEachLine(chunk(k), [](auto /*unused*/, auto /*unused*/) {});
+    });
+    std::partial_sum(rows.begin(), rows.end(), rows.begin());
+
+    values = Matrix(static_cast<Eigen::Index>(rows.back()), static_cast<Eigen::Index>(ncol));
+    tbb::parallel_for(size_t { 0 }, nchunk, [&](size_t k) {
+        ForEachLine(chunk(k), [&](std::string_view line, size_t i) {
+            auto row = rows[k] + i;
+            for (size_t col = 0; col < ncol; ++col) {
+                if (line.data() == nullptr) {
+                    throw std::runtime_error(fmt::format("Row {} has fewer than {} columns.\n", row, ncol));
+                }
+                values(static_cast<Eigen::Index>(row), static_cast<Eigen::Index>(col)) = ParseValue(NextField(line), row, col);
+            }
+            if (line.data() != nullptr) {
+                throw std::runtime_error(fmt::format("Row {} has more than {} columns.\n", row, ncol));
+            }
+        });
+    });
     return Map(values.data(), values.rows(), values.cols());
 }
 
@@ -85,8 +411,13 @@ Dataset::Dataset(std::vector<std::vector<Operon::Scalar>> const& vals)
 }
 
 Dataset::Dataset(std::string const& path, bool hasHeader)
-    : map(ReadCsv(path, hasHeader))
+    : map(IsBinary(path) ? ReadBinary(path) : ReadCsv(path, hasHeader))
 {
+    UpdateLookup();
+    // the binary format stores the bounds, so that a mapped file is not scanned when loaded
+    if (bounds.empty()) {
+        UpdateBounds();
+    }
 }
 
 Dataset::Dataset(Matrix&& vals)
@@ -94,6 +425,8 @@ Dataset::Dataset(Matrix&& vals)
     , values(std::move(vals))
     , map(values.data(), values.rows(), values.cols())
 {
+    UpdateLookup();
+    UpdateBounds();
 }
 
 Dataset::Dataset(Matrix const& vals)
@@ -101,12 +434,29 @@ Dataset::Dataset(Matrix const& vals)
     , values(vals)
     , map(values.data(), values.rows(), values.cols())
 {
+    UpdateLookup();
+    UpdateBounds();
 }
 
 Dataset::Dataset(Eigen::Ref<Matrix const> ref)
     : variables(defaultVariables((size_t)ref.cols()))
     , map(ref.data(), ref.rows(), ref.cols()) 
 {
+    UpdateLookup();
+    UpdateBounds();
+}
+
+Dataset::Dataset(std::vector<std::string> const& names, std::vector<Operon::Scalar const*> cols, size_t rows, std::shared_ptr<void const> keepAlive)
+    : columns(std::move(cols))
+    , owner(std::move(keepAlive))
+    , map(nullptr, static_cast<Eigen::Index>(rows), static_cast<Eigen::Index>(columns.size()))
+{
+    if (std::any_of(columns.begin(), columns.end(), [](auto const* p) { return p == nullptr; })) {
+        throw std::runtime_error("The columns of a dataset cannot be null.\n");
+    }
+    variables.resize(columns.size());
+    SetVariableNames(names);
+    UpdateBounds();
 }
 
 void Dataset::SetVariableNames(std::vector<std::string> const& names)
@@ -125,6 +475,7 @@ void Dataset::SetVariableNames(std::vector<std::string> const& names)
     }
 
     std::sort(variables.begin(), variables.end(), [&](auto& a, auto& b) { return a.Hash < b.Hash; });
+    UpdateLookup();
 }
 
 std::vector<std::string> Dataset::VariableNames()
@@ -140,17 +491,55 @@ gsl::span<const Operon::Scalar> Dataset::GetValues(const std::string& name) cons
     return GetValues(hashValue);
 }
 
+void Dataset::UpdateLookup()
+{
+    // open addressing with linear probing, at most half full so that the probes are short. a slot holds the position
+    // of a variable plus one, zero marking an empty slot
+    size_t size = 2;
+    while (size < 2 * variables.size()) {
+        size *= 2;
+    }
+    lookup.assign(size, 0);
+    auto mask = size - 1;
+    for (size_t i = 0; i < variables.size(); ++i) {
+        auto slot = static_cast<size_t>(variables[i].Hash) & mask;
+        while (lookup[slot] != 0) {
+            slot = (slot + 1) & mask;
+        }
+        lookup[slot] = static_cast<uint32_t>(i + 1);
+    }
+}
+
+Variable const* Dataset::Find(Operon::Hash hashValue) const noexcept
+{
+    if (lookup.empty()) {
+        return nullptr;
+    }
+    auto mask = lookup.size() - 1;
+    for (auto slot = static_cast<size_t>(hashValue) & mask; lookup[slot] != 0; slot = (slot + 1) & mask) {
+        auto const& v = variables[lookup[slot] - 1];
+        if (v.Hash == hashValue) {
+            return &v;
+        }
+    }
+    return nullptr;
+}
+
+// an unknown hash gives an empty span
 gsl::span<const Operon::Scalar> Dataset::GetValues(Operon::Hash hashValue) const noexcept
 {
-    auto it = std::partition_point(variables.begin(), variables.end(), [&](const auto& v) { return v.Hash < hashValue; });
-    auto idx = static_cast<Eigen::Index>(it->Index);
-    return gsl::span<const Operon::Scalar>(map.col(idx).data(), static_cast<size_t>(map.rows()));
+    auto const* v = Find(hashValue);
+    if (v == nullptr) {
+        return {};
+    }
+    auto idx = static_cast<Eigen::Index>(v->Index);
+    return gsl::span<const Operon::Scalar>(Column(idx).data(), static_cast<size_t>(map.rows()));
 }
 
 // this method needs to take an int argument to differentiate it from GetValues(Operon::Hash)
 gsl::span<const Operon::Scalar> Dataset::GetValues(int index) const noexcept
 {
-    return gsl::span<const Operon::Scalar>(map.col(index).data(), static_cast<size_t>(map.rows()));
+    return gsl::span<const Operon::Scalar>(Column(index).data(), static_cast<size_t>(map.rows()));
 }
 
 const std::optional<Variable> Dataset::GetVariable(const std::string& name) const noexcept
@@ -161,8 +550,59 @@ const std::optional<Variable> Dataset::GetVariable(const std::string& name) cons
 
 const std::optional<Variable> Dataset::GetVariable(Operon::Hash hashValue) const noexcept
 {
-    auto it = std::partition_point(variables.begin(), variables.end(), [&](const auto& v) { return v.Hash < hashValue; });
-    return it < variables.end() ? std::make_optional(*it) : std::nullopt; 
+    auto const* v = Find(hashValue);
+    return v != nullptr ? std::make_optional(*v) : std::nullopt;
+}
+
+void Dataset::AddPrecision(Precision precision)
+{
+    if (HasPrecision(precision)) {
+        return;
+    }
+    converted.resize(map.rows(), map.cols());
+    UpdateConverted();
+}
+
+void Dataset::UpdateConverted()
+{
+    for (Eigen::Index i = 0; i < converted.cols(); ++i) {
+        UpdateConverted(i);
+    }
+}
+
+void Dataset::UpdateConverted(Eigen::Index i)
+{
+    if (converted.size() > 0) {
+        converted.col(i) = Column(i).cast<Converted>();
+    }
+}
+
+Interval Dataset::GetBounds(Operon::Hash hashValue) const noexcept
+{
+    auto const* v = Find(hashValue);
+    return v != nullptr ? bounds[v->Index] : Interval::Undefined();
+}
+
+void Dataset::UpdateBounds()
+{
+    bounds.resize(static_cast<size_t>(map.cols()));
+    for (Eigen::Index i = 0; i < map.cols(); ++i) {
+        UpdateBounds(i);
+    }
+}
+
+void Dataset::UpdateBounds(Eigen::Index i)
+{
+    // missing (nan) or infinite values are ignored, a column without finite values is undefined
+    auto lo = std::numeric_limits<double>::infinity();
+    auto hi = -std::numeric_limits<double>::infinity();
+    for (auto v : Column(i)) {
+        if (std::isfinite(v)) {
+            lo = std::min(lo, double { v });
+            hi = std::max(hi, double { v });
+        }
+    }
+    bounds[static_cast<size_t>(i)] = lo <= hi ? Interval { lo, hi } : Interval::Undefined();
 }
 
 void Dataset::Shuffle(Operon::RandomGenerator& random)
@@ -173,6 +613,7 @@ void Dataset::Shuffle(Operon::RandomGenerator& random)
     // generate a random permutation
     std::shuffle(perm.indices().data(), perm.indices().data() + perm.indices().size(), random);
     values = perm * values.matrix(); // permute rows
+    UpdateConverted();
 }
 
 void Dataset::Normalize(size_t i, Range range)
@@ -186,6 +627,8 @@ void Dataset::Normalize(size_t i, Range range)
     auto min = seg.minCoeff();
     auto max = seg.maxCoeff();
     values.col(j) = (values.col(j).array() - min) / (max - min);
+    UpdateConverted(j);
+    UpdateBounds(j);
 }
 
 // standardize column i using mean and stddev calculated over the specified range
@@ -202,6 +645,8 @@ void Dataset::Standardize(size_t i, Range range)
     calc.Add(vals);
 
     values.col(j) = (values.col(j).array() - calc.Mean()) / calc.NaiveStandardDeviation();
+    UpdateConverted(j);
+    UpdateBounds(j);
 }
 } // namespace Operon
 
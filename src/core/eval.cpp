@@ -0,0 +1,48 @@
+/* This file is part of:
+ * Operon - Large Scale Genetic Programming Framework
+ *
+ * Licensed under the ISC License <https://opensource.org/licenses/ISC>
+ * Copyright (C) 2020 Bogdan Burlacu
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+ * REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+ * INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+ * LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+ * OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+ * PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include "core/eval.hpp"
+
+#if defined(__APPLE__)
+#include <sys/sysctl.h>
+#elif defined(__unix__)
+#include <unistd.h>
+#endif
+
+namespace Operon {
+size_t DataCacheSize() noexcept
+{
+    static size_t const size = []() -> size_t {
+        constexpr size_t fallback = 32 * 1024;
+#if defined(__APPLE__)
+        int64_t value = 0;
+        size_t length = sizeof(value);
+        if (sysctlbyname("hw.l1dcachesize", &value, &length, nullptr, 0) == 0 && value > 0) {
+            return static_cast<size_t>(value);
+        }
+#elif defined(_SC_LEVEL1_DCACHE_SIZE)
+        if (auto value = sysconf(_SC_LEVEL1_DCACHE_SIZE); value > 0) {
+            return static_cast<size_t>(value);
+        }
+#endif
+        return fallback;
+    }();
+    return size;
+}
+} // namespace Operon
@@ -0,0 +1,203 @@
+/* This file is part of:
+ * Operon - Large Scale Genetic Programming Framework
+ *
+ * Licensed under the ISC License <https://opensource.org/licenses/ISC>
+ * Copyright (C) 2020 Bogdan Burlacu
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+ * REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+ * INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+ * LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+ * OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+ * PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include "core/interval.hpp"
+
+#include <vector>
+
+#include "core/dataset.hpp"
+#include "core/tree.hpp"
+
+namespace Operon {
+
+namespace {
+    constexpr double Pi = 3.14159265358979323846;
+
+    // true if the interval contains one of the points offset + k * period (k integer)
+    bool ContainsPeriodic(Interval a, double offset, double period) noexcept
+    {
+        auto k = std::ceil((a.Lower - offset) / period);
+        return offset + k * period <= a.Upper;
+    }
+} // namespace
+
+Interval Exp(Interval a) noexcept
+{
+    return { std::exp(a.Lower), std::exp(a.Upper) };
+}
+
+Interval Log(Interval a) noexcept
+{
+    if (!a.IsDefined() || a.Lower < 0) {
+        return Interval::Undefined();
+    }
+    return { std::log(a.Lower), std::log(a.Upper) };
+}
+
+Interval Sin(Interval a) noexcept
+{
+    if (!a.IsFinite()) {
+        return Interval::Undefined();
+    }
+    if (a.Width() >= 2 * Pi) {
+        return { -1, 1 };
+    }
+    auto lo = std::sin(a.Lower);
+    auto hi = std::sin(a.Upper);
+    if (lo > hi) {
+        std::swap(lo, hi);
+    }
+    return { ContainsPeriodic(a, -Pi / 2, 2 * Pi) ? -1 : lo, ContainsPeriodic(a, Pi / 2, 2 * Pi) ? 1 : hi };
+}
+
+Interval Cos(Interval a) noexcept
+{
+    if (!a.IsFinite()) {
+        return Interval::Undefined();
+    }
+    if (a.Width() >= 2 * Pi) {
+        return { -1, 1 };
+    }
+    auto lo = std::cos(a.Lower);
+    auto hi = std::cos(a.Upper);
+    if (lo > hi) {
+        std::swap(lo, hi);
+    }
+    return { ContainsPeriodic(a, Pi, 2 * Pi) ? -1 : lo, ContainsPeriodic(a, 0, 2 * Pi) ? 1 : hi };
+}
+
+Interval Tan(Interval a) noexcept
+{
+    if (!a.IsFinite()) {
+        return Interval::Undefined();
+    }
+    if (a.Width() >= Pi || ContainsPeriodic(a, Pi / 2, Pi)) {
+        return Interval::Unbounded();
+    }
+    return { std::tan(a.Lower), std::tan(a.Upper) };
+}
+
+Interval Sqrt(Interval a) noexcept
+{
+    if (!a.IsDefined() || a.Lower < 0) {
+        return Interval::Undefined();
+    }
+    return { std::sqrt(a.Lower), std::sqrt(a.Upper) };
+}
+
+Interval Cbrt(Interval a) noexcept
+{
+    return { std::cbrt(a.Lower), std::cbrt(a.Upper) };
+}
+
+Interval Square(Interval a) noexcept
+{
+    if (!a.IsDefined()) {
+        return a;
+    }
+    auto lo = a.Lower * a.Lower;
+    auto hi = a.Upper * a.Upper;
+    return { a.Contains(0) ? 0 : std::min(lo, hi), std::max(lo, hi) };
+}
+
+Interval EvaluateInterval(Tree const& tree, Dataset const& dataset, Operon::Scalar const* parameters)
+{
+    auto const& nodes = tree.Nodes();
+    std::vector<Interval> intervals(nodes.size());
+    size_t coefficient = 0;
+
+    for (size_t i = 0; i < nodes.size(); ++i) {
+        auto const& n = nodes[i];
+
+        if (n.IsLeaf()) {
+            auto weight = Interval::Point(parameters == nullptr ? n.Value : parameters[coefficient]);
+            ++coefficient;
+            intervals[i] = n.IsVariable() ? weight * dataset.GetBounds(n.HashValue) : weight;
+            continue;
+        }
+
+        // the first argument is the child immediately preceding the parent (like in the interpreter), the other
+        // arguments of the n-ary nodes are combined first: a - (b + c + ...), a / (b * c * ...)
+        auto j = i - 1;
+        auto first = intervals[j];
+        auto rest = Interval::Point(n.Type == NodeType::Add || n.Type == NodeType::Sub ? 0 : 1);
+        for (size_t k = 1; k < n.Arity; ++k) {
+            j -= nodes[j].Length + 1ul;
+            rest = n.Type == NodeType::Add || n.Type == NodeType::Sub ? rest + intervals[j] : rest * intervals[j];
+        }
+
+        auto& r = intervals[i];
+        switch (n.Type) {
+        case NodeType::Add: {
+            r = first + rest;
+            break;
+        }
+        case NodeType::Sub: {
+            r = n.Arity == 1 ? -first : first - rest;
+            break;
+        }
+        case NodeType::Mul: {
+            r = first * rest;
+            break;
+        }
+        case NodeType::Div: {
+            r = n.Arity == 1 ? Inverse(first) : first / rest;
+            break;
+        }
+        case NodeType::Exp: {
+            r = Exp(first);
+            break;
+        }
+        case NodeType::Log: {
+            r = Log(first);
+            break;
+        }
+        case NodeType::Sin: {
+            r = Sin(first);
+            break;
+        }
+        case NodeType::Cos: {
+            r = Cos(first);
+            break;
+        }
+        case NodeType::Tan: {
+            r = Tan(first);
+            break;
+        }
+        case NodeType::Sqrt: {
+            r = Sqrt(first);
+            break;
+        }
+        case NodeType::Cbrt: {
+            r = Cbrt(first);
+            break;
+        }
+        case NodeType::Square: {
+            r = Square(first);
+            break;
+        }
+        default: {
+            r = Interval::Undefined();
+            break;
+        }
+        }
+    }
+    return intervals.empty() ? Interval::Undefined() : intervals.back();
+}
+} // namespace Operon
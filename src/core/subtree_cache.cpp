@@ -0,0 +1,121 @@
+/* This file is part of:
+ * Operon - Large Scale Genetic Programming Framework
+ *
+ * Licensed under the ISC License <https://opensource.org/licenses/ISC>
+ * Copyright (C) 2020 Bogdan Burlacu
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+ * REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+ * INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+ * LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+ * OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+ * PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include "core/subtree_cache.hpp"
+
+namespace Operon {
+namespace {
+    size_t ColumnBytes(SubtreeCache::Column const& column)
+    {
+        return column->size() * sizeof(Operon::Scalar);
+    }
+}
+
+void SubtreeCache::Bind(Dataset const& dataset, Range range)
+{
+    if (boundDataset == &dataset && boundRange.Bounds() == range.Bounds()) {
+        return;
+    }
+    entries.clear();
+    recent.clear();
+    memory = 0;
+    boundDataset = &dataset;
+    boundRange = range;
+}
+
+void SubtreeCache::Evict()
+{
+    while (memory > capacity && !recent.empty()) {
+        auto it = entries.find(recent.back());
+        memory -= ColumnBytes(it->second.Values);
+        entries.erase(it);
+        recent.pop_back();
+        ++evictions;
+    }
+}
+
+SubtreeCache::Column SubtreeCache::Get(Dataset const& dataset, Range range, Operon::Hash hash)
+{
+    std::lock_guard lock(mutex);
+    Bind(dataset, range);
+
+    auto it = entries.find(hash);
+    if (it == entries.end()) {
+        ++misses;
+        return nullptr;
+    }
+    ++hits;
+    recent.splice(recent.begin(), recent, it->second.Position);
+    return it->second.Values;
+}
+
+void SubtreeCache::Put(Dataset const& dataset, Range range, Operon::Hash hash, Column column)
+{
+    EXPECT(column != nullptr && column->size() == range.Size());
+
+    std::lock_guard lock(mutex);
+    Bind(dataset, range);
+
+    if (ColumnBytes(column) > capacity || entries.find(hash) != entries.end()) {
+        return;
+    }
+    memory += ColumnBytes(column);
+    recent.push_front(hash);
+    entries.insert({ hash, Entry { std::move(column), recent.begin() } });
+    Evict();
+}
+
+void SubtreeCache::Clear()
+{
+    std::lock_guard lock(mutex);
+    entries.clear();
+    recent.clear();
+    memory = 0;
+}
+
+size_t SubtreeCache::Size() const
+{
+    std::lock_guard lock(mutex);
+    return entries.size();
+}
+
+size_t SubtreeCache::MemoryUsage() const
+{
+    std::lock_guard lock(mutex);
+    return memory;
+}
+
+size_t SubtreeCache::Hits() const
+{
+    std::lock_guard lock(mutex);
+    return hits;
+}
+
+size_t SubtreeCache::Misses() const
+{
+    std::lock_guard lock(mutex);
+    return misses;
+}
+
+size_t SubtreeCache::Evictions() const
+{
+    std::lock_guard lock(mutex);
+    return evictions;
+}
+} // namespace Operon
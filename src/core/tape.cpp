@@ -0,0 +1,159 @@
+/* This file is part of:
+ * Operon - Large Scale Genetic Programming Framework
+ *
+ * Licensed under the ISC License <https://opensource.org/licenses/ISC>
+ * Copyright (C) 2020 Bogdan Burlacu
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+ * REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+ * INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+ * LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+ * OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+ * PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include "core/tape.hpp"
+
+namespace Operon {
+void Tape::Compile(Tree const& tree, Dataset const& dataset, bool reuseColumns, gsl::span<Operon::Scalar const* const> substitutions)
+{
+    auto const& nodes = tree.Nodes();
+    EXPECT(nodes.size() > 0);
+    EXPECT(substitutions.empty() || substitutions.size() == nodes.size());
+
+    instructions.clear();
+    arguments.clear();
+    columns = 0;
+    coefficients = 0;
+
+    // the bookkeeping buffers below are reused between calls on the same thread
+    thread_local std::vector<bool> skip;
+    thread_local std::vector<size_t> results;
+    thread_local std::vector<size_t> emitted;
+    thread_local std::vector<size_t> released;
+
+    // nodes below a substituted node are not emitted
+    skip.assign(nodes.size(), false);
+    if (!substitutions.empty()) {
+        for (size_t i = nodes.size(); i-- > 0;) {
+            if (substitutions[i] != nullptr && !skip[i]) {
+                std::fill_n(skip.begin() + static_cast<std::ptrdiff_t>(i - nodes[i].Length), nodes[i].Length, true);
+            }
+        }
+    }
+
+    instructions.reserve(nodes.size());
+    arguments.reserve(nodes.size());
+
+    // scratch column holding the value of each node
+    results.resize(nodes.size());
+    // instruction emitted for each node
+    emitted.resize(nodes.size());
+
+    // scratch columns released by already consumed nodes
+    released.clear();
+    auto allocate = [&]() {
+        if (released.empty()) {
+            return columns++;
+        }
+        auto c = released.back();
+        released.pop_back();
+        return c;
+    };
+
+    for (size_t i = 0; i < nodes.size(); ++i) {
+        auto const& n = nodes[i];
+
+        if (skip[i]) {
+            // leaves keep their position in the parameter array
+            coefficients += n.IsLeaf();
+            continue;
+        }
+
+        emitted[i] = instructions.size();
+        auto& instr = instructions.emplace_back();
+
+        instr.Opcode = n.Type;
+        instr.Arity = n.Arity;
+        instr.Fused = false;
+        instr.FusedArguments = 0;
+        instr.Arguments = arguments.size();
+        instr.Coefficient = 0;
+        instr.Value = n.Value;
+        instr.Data = nullptr;
+        instr.ConvertedData = nullptr;
+
+        auto const substituted = !substitutions.empty() && substitutions[i] != nullptr;
+
+        if (n.IsLeaf() || substituted) {
+            instr.Arity = 0;
+            instr.Result = reuseColumns ? allocate() : instructions.size() - 1;
+            results[i] = instr.Result;
+
+            if (substituted) {
+                instr.Opcode = NodeType::Variable;
+                instr.Value = 1;
+                instr.Data = substitutions[i];
+                coefficients += n.IsLeaf();
+                continue;
+            }
+
+            instr.Coefficient = coefficients++;
+            if (n.IsVariable()) {
+                instr.Data = dataset.GetValues(n.HashValue).data();
+                if (dataset.HasPrecision(PrecisionOf<Dataset::Converted>)) {
+                    instr.ConvertedData = dataset.GetValues<Dataset::Converted>(n.HashValue).data();
+                }
+            }
+            continue;
+        }
+
+        // children are stored in the same order in which the iterator visits them
+        // (the first argument is the node immediately preceding the parent)
+        // leaf arguments fused into their parent (see ExecuteFused): variables and constants of the arithmetic
+        // operations of arity at most two, variables of the unary functions
+        auto const arithmetic = n.Type == NodeType::Add || n.Type == NodeType::Sub || n.Type == NodeType::Mul || n.Type == NodeType::Div;
+        auto const fuse = reuseColumns && n.Arity <= 2 && (arithmetic || n.Arity == 1);
+        auto j = i - 1;
+        for (size_t k = 0; k < n.Arity; ++k) {
+            auto& child = instructions[emitted[j]];
+            if (fuse && (child.Opcode == NodeType::Variable || (arithmetic && child.Opcode == NodeType::Constant))) {
+                // the column of the leaf is still allocated (and released below), but never written
+                child.Fused = true;
+                instr.FusedArguments |= static_cast<uint8_t>(1u << k);
+                arguments.push_back(emitted[j]);
+            } else {
+                arguments.push_back(results[j]);
+            }
+            j -= nodes[j].Length + 1ul;
+        }
+
+        if (!reuseColumns) {
+            instr.Result = instructions.size() - 1;
+            results[i] = instr.Result;
+            continue;
+        }
+
+        // a child value is only live until its parent is computed (each node has exactly one parent),
+        // so the parent overwrites the column of its first child and the other children's columns
+        // are returned to the pool. the number of columns in use is bounded by the maximum
+        // evaluation stack depth instead of the number of nodes
+        instr.Result = results[i - 1];
+        results[i] = instr.Result;
+        j = i - 1;
+        for (size_t k = 1; k < n.Arity; ++k) {
+            j -= nodes[j].Length + 1ul;
+            released.push_back(results[j]);
+        }
+    }
+
+    if (!reuseColumns) {
+        columns = instructions.size();
+    }
+}
+} // namespace Operon
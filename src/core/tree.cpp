@@ -18,8 +18,10 @@
  */
 
 #include <algorithm>
+#include <cmath>
 #include <iostream>
 #include <iterator>
+#include <limits>
 #include <numeric>
 #include <optional>
 #include <stack>
@@ -84,6 +86,322 @@ Tree& Tree::Reduce()
     return this->UpdateNodes();
 }
 
+namespace {
+    // recursive view of a (sub)tree used by the simplifier, the arguments are stored in evaluation order
+    // (the first argument corresponds to the node immediately preceding the parent in postfix order)
+    struct Expression {
+        Node Symbol;
+        std::vector<Expression> Arguments;
+    };
+
+    Expression Build(Tree const& tree, size_t i)
+    {
+        Expression e { tree[i], {} };
+        if (!tree[i].IsLeaf()) {
+            e.Arguments.reserve(tree[i].Arity);
+            for (auto it = tree.Children(i); it.HasNext(); ++it) {
+                e.Arguments.push_back(Build(tree, it.Index()));
+            }
+        }
+        return e;
+    }
+
+    void Flatten(Expression const& e, Operon::Vector<Node>& nodes)
+    {
+        for (auto it = e.Arguments.rbegin(); it != e.Arguments.rend(); ++it) {
+            Flatten(*it, nodes);
+        }
+        auto& n = nodes.emplace_back(e.Symbol);
+        n.Arity = static_cast<uint16_t>(e.Arguments.size());
+        n.IsEnabled = true;
+    }
+
+    Expression Constant(Operon::Scalar value)
+    {
+        Node n(NodeType::Constant);
+        n.Value = value;
+        return { n, {} };
+    }
+
+    bool IsConstant(Expression const& e, Operon::Scalar value)
+    {
+        return e.Symbol.IsConstant() && e.Symbol.Value == value;
+    }
+
+    // structural equality, including the coefficient values
+    bool Equal(Expression const& a, Expression const& b)
+    {
+        auto const& x = a.Symbol;
+        auto const& y = b.Symbol;
+        return x.Type == y.Type && x.HashValue == y.HashValue && (!x.IsLeaf() || x.Value == y.Value)
+            && std::equal(a.Arguments.begin(), a.Arguments.end(), b.Arguments.begin(), b.Arguments.end(), Equal);
+    }
+
+    // value of a function whose arguments are constants, with the same semantics as the interpreter (see core/eval_detail.hpp)
+    Operon::Scalar Fold(NodeType type, std::vector<Operon::Scalar> const& v)
+    {
+        auto tail = [&](auto op, Operon::Scalar init) { return std::accumulate(v.begin() + 1, v.end(), init, op); };
+        switch (type) {
+        case NodeType::Add:
+            return v.size() == 1 ? v[0] : v[0] + tail(std::plus<> {}, Operon::Scalar { 0 });
+        case NodeType::Sub:
+            return v.size() == 1 ? -v[0] : v[0] - tail(std::plus<> {}, Operon::Scalar { 0 });
+        case NodeType::Mul:
+            return v.size() == 1 ? v[0] : v[0] * tail(std::multiplies<> {}, Operon::Scalar { 1 });
+        case NodeType::Div:
+            return v.size() == 1 ? 1 / v[0] : v[0] / tail(std::multiplies<> {}, Operon::Scalar { 1 });
+        case NodeType::Log:
+            return std::log(v[0]);
+        case NodeType::Exp:
+            return std::exp(v[0]);
+        case NodeType::Sin:
+            return std::sin(v[0]);
+        case NodeType::Cos:
+            return std::cos(v[0]);
+        case NodeType::Tan:
+            return std::tan(v[0]);
+        case NodeType::Sqrt:
+            return std::sqrt(v[0]);
+        case NodeType::Cbrt:
+            return std::cbrt(v[0]);
+        case NodeType::Square:
+            return v[0] * v[0];
+        default:
+            return std::numeric_limits<Operon::Scalar>::quiet_NaN();
+        }
+    }
+
+    // replace the arguments in [first, last) of type `type` with their own arguments
+    void Splice(std::vector<Expression>& arguments, size_t first, NodeType type)
+    {
+        std::vector<Expression> result(std::make_move_iterator(arguments.begin()), std::make_move_iterator(arguments.begin() + static_cast<std::ptrdiff_t>(first)));
+        for (auto it = arguments.begin() + static_cast<std::ptrdiff_t>(first); it != arguments.end(); ++it) {
+            if (it->Symbol.Type == type) {
+                std::move(it->Arguments.begin(), it->Arguments.end(), std::back_inserter(result));
+            } else {
+                result.push_back(std::move(*it));
+            }
+        }
+        arguments.swap(result);
+    }
+
+    // returns the single argument, a neutral constant if there are no arguments, or the expression itself
+    Expression Collapse(Expression e, Operon::Scalar neutral)
+    {
+        if (e.Arguments.empty()) {
+            return Constant(neutral);
+        }
+        if (e.Arguments.size() == 1) {
+            return std::move(e.Arguments.front());
+        }
+        return e;
+    }
+
+    // sum: constants are folded into one, variables with the same hash are merged by adding their weights
+    Expression SimplifyAdd(Expression e)
+    {
+        Operon::Scalar c { 0 };
+        std::vector<Expression> terms;
+        for (auto& a : e.Arguments) {
+            auto const& s = a.Symbol;
+            if (s.IsConstant()) {
+                c += s.Value;
+            } else if (auto it = std::find_if(terms.begin(), terms.end(), [&](auto const& t) { return s.IsVariable() && t.Symbol.IsVariable() && t.Symbol.HashValue == s.HashValue; }); it != terms.end()) {
+                it->Symbol.Value += s.Value;
+            } else {
+                terms.push_back(std::move(a));
+            }
+        }
+        // x - x
+        terms.erase(std::remove_if(terms.begin(), terms.end(), [](auto const& t) { return t.Symbol.IsVariable() && t.Symbol.Value == 0; }), terms.end());
+        if (c != 0) {
+            terms.push_back(Constant(c));
+        }
+        e.Arguments.swap(terms);
+        return Collapse(std::move(e), 0);
+    }
+
+    // product: constants are folded into one and absorbed into the weight of a variable (if there is one), zero annihilates
+    Expression SimplifyMul(Expression e)
+    {
+        Operon::Scalar c { 1 };
+        std::vector<Expression> factors;
+        for (auto& a : e.Arguments) {
+            if (a.Symbol.IsConstant()) {
+                c *= a.Symbol.Value;
+            } else {
+                factors.push_back(std::move(a));
+            }
+        }
+        if (c == 0) {
+            return Constant(0);
+        }
+        if (c != 1) {
+            if (auto it = std::find_if(factors.begin(), factors.end(), [](auto const& f) { return f.Symbol.IsVariable(); }); it != factors.end()) {
+                it->Symbol.Value *= c;
+            } else {
+                factors.push_back(Constant(c));
+            }
+        }
+        e.Arguments.swap(factors);
+        return Collapse(std::move(e), 1);
+    }
+
+    // difference a - (b + c + ...): leaf subtrahends are negated and merged into a sum with the minuend
+    Expression SimplifySub(Expression e)
+    {
+        auto& args = e.Arguments;
+        if (args.size() == 1) {
+            auto& a = args.front();
+            if (a.Symbol.IsLeaf()) {
+                a.Symbol.Value = -a.Symbol.Value;
+                return std::move(a);
+            }
+            if (a.Symbol.IsSubtraction() && a.Arguments.size() == 1) {
+                return std::move(a.Arguments.front());
+            }
+            return e;
+        }
+
+        if (std::all_of(args.begin() + 1, args.end(), [](auto const& a) { return a.Symbol.IsLeaf(); })) {
+            Expression sum { Node(NodeType::Add), {} };
+            for (size_t i = 0; i < args.size(); ++i) {
+                if (i > 0) {
+                    args[i].Symbol.Value = -args[i].Symbol.Value;
+                }
+                if (args[i].Symbol.IsAddition()) {
+                    std::move(args[i].Arguments.begin(), args[i].Arguments.end(), std::back_inserter(sum.Arguments));
+                } else {
+                    sum.Arguments.push_back(std::move(args[i]));
+                }
+            }
+            return SimplifyAdd(std::move(sum));
+        }
+
+        if (args.size() == 2 && Equal(args[0], args[1])) {
+            return Constant(0);
+        }
+
+        // fold the constant subtrahends
+        auto isConstant = [](auto const& a) { return a.Symbol.IsConstant(); };
+        Operon::Scalar c { 0 };
+        for (auto it = args.begin() + 1; it != args.end(); ++it) {
+            c += isConstant(*it) ? it->Symbol.Value : Operon::Scalar { 0 };
+        }
+        args.erase(std::remove_if(args.begin() + 1, args.end(), isConstant), args.end());
+        if (c != 0) {
+            args.push_back(Constant(c));
+        }
+        return args.size() == 1 ? std::move(args.front()) : e;
+    }
+
+    // quotient a / (b * c * ...): constant divisors are folded into one and absorbed into a leaf numerator
+    Expression SimplifyDiv(Expression e)
+    {
+        auto& args = e.Arguments;
+        if (args.size() == 1) {
+            auto& a = args.front();
+            if (a.Symbol.IsDivision() && a.Arguments.size() == 1) {
+                return std::move(a.Arguments.front());
+            }
+            return e;
+        }
+
+        if (IsConstant(args[0], 0)) {
+            return Constant(0);
+        }
+        if (args.size() == 2 && Equal(args[0], args[1])) {
+            return Constant(1);
+        }
+
+        auto isConstant = [](auto const& a) { return a.Symbol.IsConstant(); };
+        Operon::Scalar c { 1 };
+        for (auto it = args.begin() + 1; it != args.end(); ++it) {
+            c *= isConstant(*it) ? it->Symbol.Value : Operon::Scalar { 1 };
+        }
+        args.erase(std::remove_if(args.begin() + 1, args.end(), isConstant), args.end());
+        if (c != 1) {
+            if (args[0].Symbol.IsLeaf()) {
+                args[0].Symbol.Value /= c;
+            } else {
+                args.push_back(Constant(c));
+            }
+        }
+        return args.size() == 1 ? std::move(args.front()) : e;
+    }
+
+    Expression Rewrite(Expression e)
+    {
+        if (e.Symbol.IsLeaf()) {
+            return e;
+        }
+
+        auto& args = e.Arguments;
+        for (auto& a : args) {
+            a = Rewrite(std::move(a));
+        }
+
+        // n-ary flattening: nested sums/products, a - (b + c) and a / (b * c)
+        auto const type = e.Symbol.Type;
+        if (type == NodeType::Add || type == NodeType::Mul) {
+            Splice(args, 0, type);
+        } else if (type == NodeType::Sub || type == NodeType::Div) {
+            if (args.size() > 1) {
+                Splice(args, 1, type == NodeType::Sub ? NodeType::Add : NodeType::Mul);
+            }
+            // (a - b) - c = a - (b + c) and (a / b) / c = a / (b * c)
+            if (args.size() > 1 && args[0].Symbol.Type == type && args[0].Arguments.size() > 1) {
+                auto first = std::move(args[0]);
+                std::move(args.begin() + 1, args.end(), std::back_inserter(first.Arguments));
+                args.swap(first.Arguments);
+            }
+        }
+
+        // constant folding
+        if (std::all_of(args.begin(), args.end(), [](auto const& a) { return a.Symbol.IsConstant(); })) {
+            std::vector<Operon::Scalar> values(args.size());
+            std::transform(args.begin(), args.end(), values.begin(), [](auto const& a) { return a.Symbol.Value; });
+            if (auto v = Fold(type, values); std::isfinite(v)) {
+                return Constant(v);
+            }
+            return e;
+        }
+
+        switch (type) {
+        case NodeType::Add:
+            return SimplifyAdd(std::move(e));
+        case NodeType::Mul:
+            return SimplifyMul(std::move(e));
+        case NodeType::Sub:
+            return SimplifySub(std::move(e));
+        case NodeType::Div:
+            return SimplifyDiv(std::move(e));
+        default:
+            return e;
+        }
+    }
+} // namespace
+
+// Simplify the tree using semantics-preserving rewrites applied bottom-up:
+// - constant folding (subtrees containing only constants are replaced with their value)
+// - n-ary flattening of nested sums and products (also a - (b + c) and a / (b * c))
+// - elimination of identities (x + 0, x * 1, x / 1, x - 0) and annihilators (x * 0, 0 / x)
+// - merging of like terms: weighted variables in a sum, x - x = 0, x / x = 1, constants absorbed into variable weights
+// the result evaluates to the same values up to floating point rounding, except for rows where an annihilated
+// subtree is not finite (eg. 0 * log(0) becomes 0). the node hash values are not updated
+Tree& Tree::Simplify()
+{
+    if (nodes.empty()) {
+        return *this;
+    }
+    auto e = Rewrite(Build(*this, nodes.size() - 1));
+    Operon::Vector<Node> simplified;
+    simplified.reserve(nodes.size());
+    Flatten(e, simplified);
+    nodes.swap(simplified);
+    return this->UpdateNodes();
+}
+
 // Sort each function node's children according to node type and hash value
 // - note that entire child subtrees / subarrays are reordered inside the nodes array
 // - this method assumes node hashes are computed, usually it is preceded by a call to tree.Hash()
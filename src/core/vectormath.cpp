@@ -0,0 +1,104 @@
+/* This file is part of:
+ * Operon - Large Scale Genetic Programming Framework
+ *
+ * Licensed under the ISC License <https://opensource.org/licenses/ISC>
+ * Copyright (C) 2020 Bogdan Burlacu
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+ * REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+ * INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+ * LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+ * OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+ * PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include "core/vectormath.hpp"
+#include "core/contracts.hpp"
+#include "vectormath_kernels.hpp"
+
+#include <atomic>
+#include <cmath>
+
+namespace Operon::VectorMath {
+namespace Scalar {
+    template <typename T, typename F>
+    void Apply(T const* x, T* y, size_t n, F&& f) noexcept
+    {
+        for (size_t i = 0; i < n; ++i) {
+            y[i] = f(x[i]);
+        }
+    }
+} // namespace Scalar
+
+namespace {
+    std::atomic<InstructionSet> selected { Supported() };
+}
+
+InstructionSet Supported() noexcept
+{
+#if defined(OPERON_VECTORMATH_X86)
+    // may be called during static initialization, before the cpu features were detected
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512dq")) {
+        return InstructionSet::AVX512;
+    }
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+        return InstructionSet::AVX2;
+    }
+#endif
+    return InstructionSet::Scalar;
+}
+
+InstructionSet Selected() noexcept
+{
+    return selected.load(std::memory_order_relaxed);
+}
+
+void Select(InstructionSet set)
+{
+    EXPECT(static_cast<int>(set) <= static_cast<int>(Supported()));
+    selected.store(set, std::memory_order_relaxed);
+}
+
+#if defined(OPERON_VECTORMATH_X86)
+#define OPERON_VECTORMATH_DISPATCH(F, T, f)                              \
+    void F(T const* x, T* y, size_t n) noexcept                          \
+    {                                                                    \
+        switch (Selected()) {                                            \
+        case InstructionSet::AVX512:                                     \
+            AVX512::F(x, y, n);                                          \
+            return;                                                      \
+        case InstructionSet::AVX2:                                       \
+            AVX2::F(x, y, n);                                            \
+            return;                                                      \
+        default:                                                         \
+            Scalar::Apply(x, y, n, [](T v) { return f(v); });            \
+        }                                                                \
+    }
+#else
+#define OPERON_VECTORMATH_DISPATCH(F, T, f)                              \
+    void F(T const* x, T* y, size_t n) noexcept                          \
+    {                                                                    \
+        Scalar::Apply(x, y, n, [](T v) { return f(v); });                \
+    }
+#endif
+
+OPERON_VECTORMATH_DISPATCH(Exp, float, std::exp)
+OPERON_VECTORMATH_DISPATCH(Log, float, std::log)
+OPERON_VECTORMATH_DISPATCH(Sin, float, std::sin)
+OPERON_VECTORMATH_DISPATCH(Cos, float, std::cos)
+OPERON_VECTORMATH_DISPATCH(Tan, float, std::tan)
+OPERON_VECTORMATH_DISPATCH(Cbrt, float, std::cbrt)
+OPERON_VECTORMATH_DISPATCH(Exp, double, std::exp)
+OPERON_VECTORMATH_DISPATCH(Log, double, std::log)
+OPERON_VECTORMATH_DISPATCH(Sin, double, std::sin)
+OPERON_VECTORMATH_DISPATCH(Cos, double, std::cos)
+OPERON_VECTORMATH_DISPATCH(Tan, double, std::tan)
+OPERON_VECTORMATH_DISPATCH(Cbrt, double, std::cbrt)
+#undef OPERON_VECTORMATH_DISPATCH
+} // namespace Operon::VectorMath
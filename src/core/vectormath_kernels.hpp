@@ -0,0 +1,435 @@
+/* This file is part of:
+ * Operon - Large Scale Genetic Programming Framework
+ *
+ * Licensed under the ISC License <https://opensource.org/licenses/ISC>
+ * Copyright (C) 2020 Bogdan Burlacu
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+ * REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+ * INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+ * LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+ * OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+ * PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifndef OPERON_VECTORMATH_KERNELS
+#define OPERON_VECTORMATH_KERNELS
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+
+#include "core/vectormath.hpp"
+
+// the vectorized kernels are written with the GCC/Clang vector extensions and compiled once per instruction set,
+// by translation units built with the corresponding target flags (see vectormath_avx2.cpp and vectormath_avx512.cpp)
+#if (defined(__GNUC__) || defined(__clang__)) && defined(__x86_64__)
+#define OPERON_VECTORMATH_X86
+#endif
+
+namespace Operon::VectorMath {
+#if defined(OPERON_VECTORMATH_X86)
+#define OPERON_VECTORMATH_DECLARE(ISA)                            \
+    namespace ISA {                                               \
+        void Exp(float const* x, float* y, size_t n) noexcept;    \
+        void Log(float const* x, float* y, size_t n) noexcept;    \
+        void Sin(float const* x, float* y, size_t n) noexcept;    \
+        void Cos(float const* x, float* y, size_t n) noexcept;    \
+        void Tan(float const* x, float* y, size_t n) noexcept;    \
+        void Cbrt(float const* x, float* y, size_t n) noexcept;   \
+        void Exp(double const* x, double* y, size_t n) noexcept;  \
+        void Log(double const* x, double* y, size_t n) noexcept;  \
+        void Sin(double const* x, double* y, size_t n) noexcept;  \
+        void Cos(double const* x, double* y, size_t n) noexcept;  \
+        void Tan(double const* x, double* y, size_t n) noexcept;  \
+        void Cbrt(double const* x, double* y, size_t n) noexcept; \
+    }
+
+OPERON_VECTORMATH_DECLARE(AVX2)
+OPERON_VECTORMATH_DECLARE(AVX512)
+#undef OPERON_VECTORMATH_DECLARE
+
+namespace detail {
+// the kernels have internal linkage, so that each translation unit keeps the code generated for its own instruction set
+namespace {
+    template <typename T>
+    struct Constants;
+
+    template <>
+    struct Constants<double> {
+        using Int = int64_t;
+
+        static constexpr int MantissaBits = 52;
+        static constexpr Int MantissaMask = (Int { 1 } << MantissaBits) - 1;
+        static constexpr Int Bias = 1023;
+        static constexpr double Round = 0x1.8p52; // adding and subtracting it rounds to the nearest integer (for |x| < 2^51)
+
+        // exp: x = n ln2 + r with |r| <= ln2 / 2, exp(r) = 1 + r + r^2 P(r) with the Taylor series up to r^13
+        static constexpr double ExpMin = -746.0;
+        static constexpr double ExpMax = 710.0;
+        static constexpr double Log2e = 1.44269504088896338700e+00;
+        static constexpr double Ln2Hi = 6.93147180369123816490e-01;
+        static constexpr double Ln2Lo = 1.90821492927058770002e-10;
+        static constexpr double ExpP[] = { 1.0 / 2, 1.0 / 6, 1.0 / 24, 1.0 / 120, 1.0 / 720, 1.0 / 5040, 1.0 / 40320, 1.0 / 362880,
+            1.0 / 3628800, 1.0 / 39916800, 1.0 / 479001600, 1.0 / 6227020800 };
+
+        // log: x = 2^e m with sqrt(2)/2 <= m < sqrt(2), log(m) = log(1 + f) with the fdlibm e_log.c approximation
+        static constexpr double Subnormal = 0x1p54;
+        static constexpr Int SubnormalExponent = 54;
+        static constexpr double LogP[] = { 6.666666666666735130e-01, 3.999999999940941908e-01, 2.857142874366239149e-01, 2.222219843214978396e-01,
+            1.818357216161805012e-01, 1.531383769920937332e-01, 1.479819860511658591e-01 };
+
+        // sin, cos: x = n pi/2 + r with |r| <= pi/4 (Cody-Waite reduction with 33-bit parts of pi/2, exact for n < 2^20)
+        // sin(r) and cos(r) use the fdlibm k_sin.c and k_cos.c approximations
+        static constexpr double TrigMax = 0x1p19;
+        static constexpr double TwoOverPi = 6.36619772367581382433e-01;
+        static constexpr double PiOverTwo[] = { 1.57079632673412561417e+00, 6.07710050630396597660e-11, 2.02226624871116645580e-21 };
+        static constexpr double SinP[] = { -1.66666666666666324348e-01, 8.33333333332248946124e-03, -1.98412698298579493134e-04,
+            2.75573137070700676789e-06, -2.50507602534068634195e-08, 1.58969099521155010221e-10 };
+        static constexpr double CosP[] = { 4.16666666666666019037e-02, -1.38888888888741095749e-03, 2.48015872894767294178e-05,
+            -2.75573143513906633035e-07, 2.08757232129817482790e-09, -1.13596475577881948265e-11 };
+
+        // cbrt: |x| = 2^(3q + k) m with 1 <= m < 2, a linear guess for cbrt(2^k m) is refined by two Halley iterations
+        static constexpr double CbrtP[] = { 0.7445, 0.262 };
+        static constexpr double Cbrt2 = 1.25992104989487316477;
+        static constexpr double Cbrt4 = 1.58740105196819947475;
+    };
+
+    template <>
+    struct Constants<float> {
+        using Int = int32_t;
+
+        static constexpr int MantissaBits = 23;
+        static constexpr Int MantissaMask = (Int { 1 } << MantissaBits) - 1;
+        static constexpr Int Bias = 127;
+        static constexpr float Round = 0x1.8p23f;
+
+        static constexpr float ExpMin = -104.0f;
+        static constexpr float ExpMax = 89.0f;
+        static constexpr float Log2e = 1.44269502e+00f;
+        static constexpr float Ln2Hi = 6.93145752e-01f;
+        static constexpr float Ln2Lo = 1.42860677e-06f;
+        static constexpr float ExpP[] = { 1.0f / 2, 1.0f / 6, 1.0f / 24, 1.0f / 120, 1.0f / 720, 1.0f / 5040, 1.0f / 40320 };
+
+        static constexpr float Subnormal = 0x1p24f;
+        static constexpr Int SubnormalExponent = 24;
+        static constexpr float LogP[] = { 6.6666662693e-01f, 4.0000972152e-01f, 2.8498786688e-01f, 2.4279078841e-01f };
+
+        // Cephes sinf.c and cosf.c (with the cos polynomial evaluated like in fdlibm), the argument is reduced in double precision
+        static constexpr float TrigMax = 0x1p19f;
+        static constexpr float SinP[] = { -1.6666654611e-1f, 8.3321608736e-3f, -1.9515295891e-4f };
+        static constexpr float CosP[] = { 4.166664568298827e-2f, -1.388731625493765e-3f, 2.443315711809948e-5f };
+
+        static constexpr float CbrtP[] = { 0.7445f, 0.262f };
+        static constexpr float Cbrt2 = 1.25992105f;
+        static constexpr float Cbrt4 = 1.58740105f;
+    };
+
+    // W lanes of type T and the corresponding integer lanes (comparisons between V values yield I masks of 0 or -1)
+    template <typename T, size_t W>
+    struct Pack {
+        using Int = typename Constants<T>::Int;
+        typedef T V __attribute__((vector_size(W * sizeof(T))));
+        typedef Int I __attribute__((vector_size(W * sizeof(T))));
+    };
+
+    template <typename T, typename V>
+    inline V Broadcast(T value)
+    {
+        return V {} + value;
+    }
+
+    // evaluate c[0] + c[1] x + ... + c[N-1] x^(N-1)
+    template <typename T, size_t N, typename V>
+    inline V Polynomial(V x, T const (&c)[N])
+    {
+        V p = Broadcast<T, V>(c[N - 1]);
+        for (size_t i = N - 1; i-- > 0;) {
+            p = p * x + c[i];
+        }
+        return p;
+    }
+
+    template <typename T, typename V, typename I>
+    inline V Abs(V x)
+    {
+        return (V)((I)x & std::numeric_limits<typename Constants<T>::Int>::max());
+    }
+
+    // round to the nearest integer, returned both as floating point and integer lanes
+    template <typename T, typename V, typename I>
+    inline V Round(V x, I& n)
+    {
+        using C = Constants<T>;
+        V k = x + C::Round;
+        n = (I)k - (I)Broadcast<T, V>(C::Round);
+        return k - C::Round;
+    }
+
+    // convert (small) integer lanes to floating point
+    template <typename T, typename V, typename I>
+    inline V ToFloat(I n)
+    {
+        using C = Constants<T>;
+        return (V)(n + (I)Broadcast<T, V>(C::Round)) - C::Round;
+    }
+
+    // unbiased exponent of positive normal values (with a logical shift, since AVX2 has no arithmetic shift of 64-bit lanes)
+    template <typename T, typename I>
+    inline I Exponent(I b)
+    {
+        using C = Constants<T>;
+        typedef std::make_unsigned_t<typename C::Int> U __attribute__((vector_size(sizeof(I))));
+        return (I)((U)b >> C::MantissaBits) - C::Bias;
+    }
+
+    // 2^n for n in the range of normal exponents
+    template <typename T, typename V, typename I>
+    inline V Pow2(I n)
+    {
+        using C = Constants<T>;
+        return (V)((n + C::Bias) << C::MantissaBits);
+    }
+
+    template <typename T, typename V, typename I>
+    inline V Exp(V x)
+    {
+        using C = Constants<T>;
+        V xc = x < C::ExpMin ? Broadcast<T, V>(C::ExpMin) : x;
+        xc = xc > C::ExpMax ? Broadcast<T, V>(C::ExpMax) : xc;
+
+        I n;
+        V k = Round<T, V, I>(xc * C::Log2e, n);
+        V r = (xc - k * C::Ln2Hi) - k * C::Ln2Lo;
+        V p = T { 1 } + (r + r * r * Polynomial(r, C::ExpP));
+
+        // scale in two steps so that the result can overflow to infinity or underflow to zero, with n1 = floor(n / 2)
+        I n1;
+        Round<T, V, I>(k * T { 0.5 } - T { 0.25 }, n1);
+        V y = p * Pow2<T, V, I>(n1) * Pow2<T, V, I>(n - n1);
+        return x != x ? x : y;
+    }
+
+    template <typename T, typename V, typename I>
+    inline V Log(V x)
+    {
+        using C = Constants<T>;
+        constexpr auto inf = std::numeric_limits<T>::infinity();
+
+        // subnormal arguments are scaled into the normal range first
+        I tiny = x < std::numeric_limits<T>::min();
+        V xs = tiny ? x * C::Subnormal : x;
+
+        I b = (I)xs;
+        I e = Exponent<T>(b) - (tiny & C::SubnormalExponent);
+        V m = (V)((b & C::MantissaMask) | (I)Broadcast<T, V>(T { 1 }));
+        I big = m > static_cast<T>(M_SQRT2);
+        m = big ? m * T { 0.5 } : m;
+        e -= big;
+
+        V f = m - T { 1 };
+        V s = f / (f + T { 2 });
+        V z = s * s;
+        V hfsq = T { 0.5 } * f * f;
+        V r = z * Polynomial(z, C::LogP);
+        V k = ToFloat<T, V, I>(e);
+        V y = k * C::Ln2Hi - ((hfsq - (s * (hfsq + r) + k * C::Ln2Lo)) - f);
+
+        y = x == inf ? x : y;
+        y = x == T { 0 } ? Broadcast<T, V>(-inf) : y;
+        y = x < T { 0 } ? Broadcast<T, V>(std::numeric_limits<T>::quiet_NaN()) : y;
+        return x != x ? x : y;
+    }
+
+    // reduce the argument to x = n pi/2 + r with |r| <= pi/4
+    template <typename T, typename V, typename I>
+    inline V Reduce(V x, I& n)
+    {
+        if constexpr (std::is_same_v<T, float>) {
+            // single-precision arguments are reduced in double precision, which avoids the cancellation near multiples of pi/2
+            using P = Pack<double, sizeof(V) / sizeof(T)>;
+            typename P::I m;
+            auto r = Reduce<double, typename P::V, typename P::I>(__builtin_convertvector(x, typename P::V), m);
+            n = __builtin_convertvector(m, I);
+            return __builtin_convertvector(r, V);
+        } else {
+            using C = Constants<T>;
+            V k = Round<T, V, I>(x * C::TwoOverPi, n);
+            V r = x - k * C::PiOverTwo[0];
+            r -= k * C::PiOverTwo[1];
+            r -= k * C::PiOverTwo[2];
+            return r;
+        }
+    }
+
+    // sin(r) and cos(r) of the reduced argument x = n pi/2 + r
+    template <typename T, typename V, typename I>
+    inline void SinCos(V x, V& s, V& c, I& n)
+    {
+        using C = Constants<T>;
+        V r = Reduce<T, V, I>(x, n);
+        V z = r * r;
+        s = r + r * z * Polynomial(z, C::SinP);
+
+        V hz = T { 0.5 } * z;
+        V w = T { 1 } - hz;
+        c = w + (((T { 1 } - w) - hz) + z * z * Polynomial(z, C::CosP));
+    }
+
+    template <typename T, typename V, typename I>
+    inline V Sin(V x)
+    {
+        V s, c;
+        I n;
+        SinCos<T, V, I>(x, s, c, n);
+        V y = (n & 1) != 0 ? c : s;
+        return (n & 2) != 0 ? -y : y;
+    }
+
+    template <typename T, typename V, typename I>
+    inline V Cos(V x)
+    {
+        V s, c;
+        I n;
+        SinCos<T, V, I>(x, s, c, n);
+        V y = (n & 1) != 0 ? s : c;
+        return ((n + 1) & 2) != 0 ? -y : y;
+    }
+
+    template <typename T, typename V, typename I>
+    inline V Tan(V x)
+    {
+        V s, c;
+        I n;
+        SinCos<T, V, I>(x, s, c, n);
+        return (n & 1) != 0 ? -c / s : s / c;
+    }
+
+    template <typename T, typename V, typename I>
+    inline V Cbrt(V x)
+    {
+        using C = Constants<T>;
+        constexpr auto inf = std::numeric_limits<T>::infinity();
+
+        V a = Abs<T, V, I>(x);
+        I tiny = a < std::numeric_limits<T>::min();
+        V as = tiny ? a * C::Subnormal : a;
+
+        // |x| = 2^e m = 2^(3q + k) m with k in {0, 1, 2}
+        I b = (I)as;
+        I e = Exponent<T>(b) - (tiny & C::SubnormalExponent);
+        V m = (V)((b & C::MantissaMask) | (I)Broadcast<T, V>(T { 1 }));
+        V ef = ToFloat<T, V, I>(e);
+        I q;
+        V qf = Round<T, V, I>((ef - T { 1 }) * (T { 1 } / 3), q);
+        V k = ef - T { 3 } * qf;
+
+        // cbrt(t) with t = 2^k m in [1, 8)
+        V t = k == T { 0 } ? m : (k == T { 1 } ? m * T { 2 } : m * T { 4 });
+        V y = Polynomial(m, C::CbrtP) * (k == T { 0 } ? Broadcast<T, V>(T { 1 }) : (k == T { 1 } ? Broadcast<T, V>(C::Cbrt2) : Broadcast<T, V>(C::Cbrt4)));
+        for (int i = 0; i < 2; ++i) {
+            V y3 = y * y * y;
+            y -= y * (y3 - t) / (y3 + y3 + t);
+        }
+        y *= Pow2<T, V, I>(q);
+        y = (V)((I)y | ((I)x & std::numeric_limits<typename C::Int>::min()));
+
+        I special = (a == T { 0 }) | (a == inf) | (x != x);
+        return special ? x : y;
+    }
+
+    // replace the lanes with |x| > limit (which the vectorized kernel does not handle) with the result of the scalar function
+    template <typename T, typename V, typename I, typename F>
+    inline V Fallback(V x, V y, T limit, F&& f)
+    {
+        constexpr size_t lanes = sizeof(V) / sizeof(T);
+        I large = Abs<T, V, I>(x) > limit;
+        typename Constants<T>::Int any { 0 };
+        for (size_t i = 0; i < lanes; ++i) {
+            any |= large[i];
+        }
+        if (any) {
+            for (size_t i = 0; i < lanes; ++i) {
+                if (large[i]) {
+                    y[i] = f(x[i]);
+                }
+            }
+        }
+        return y;
+    }
+
+    // apply the kernel to x[0..n) with vectors of W lanes
+    template <typename T, size_t W, typename F>
+    inline void Apply(T const* x, T* y, size_t n, F&& kernel)
+    {
+        using V = typename Pack<T, W>::V;
+        size_t i = 0;
+        for (; i + W <= n; i += W) {
+            V v;
+            std::memcpy(&v, x + i, sizeof(V));
+            v = kernel(v);
+            std::memcpy(y + i, &v, sizeof(V));
+        }
+        if (i < n) {
+            // the last vector is padded with ones, which are valid arguments for all the functions
+            auto v = Broadcast<T, V>(T { 1 });
+            std::memcpy(&v, x + i, (n - i) * sizeof(T));
+            v = kernel(v);
+            std::memcpy(y + i, &v, (n - i) * sizeof(T));
+        }
+    }
+} // namespace
+} // namespace detail
+
+// define the functions of the given namespace using vectors of W lanes of type T
+#define OPERON_VECTORMATH_DEFINE(T, W)                                                                                   \
+    void Exp(T const* x, T* y, size_t n) noexcept                                                                         \
+    {                                                                                                                     \
+        using P = detail::Pack<T, W>;                                                                                     \
+        detail::Apply<T, W>(x, y, n, [](P::V v) { return detail::Exp<T, P::V, P::I>(v); });                               \
+    }                                                                                                                     \
+    void Log(T const* x, T* y, size_t n) noexcept                                                                         \
+    {                                                                                                                     \
+        using P = detail::Pack<T, W>;                                                                                     \
+        detail::Apply<T, W>(x, y, n, [](P::V v) { return detail::Log<T, P::V, P::I>(v); });                               \
+    }                                                                                                                     \
+    void Sin(T const* x, T* y, size_t n) noexcept                                                                         \
+    {                                                                                                                     \
+        using P = detail::Pack<T, W>;                                                                                     \
+        detail::Apply<T, W>(x, y, n, [](P::V v) {                                                                         \
+            return detail::Fallback<T, P::V, P::I>(v, detail::Sin<T, P::V, P::I>(v), detail::Constants<T>::TrigMax,      \
+                [](T u) { return std::sin(u); });                                                                         \
+        });                                                                                                               \
+    }                                                                                                                     \
+    void Cos(T const* x, T* y, size_t n) noexcept                                                                         \
+    {                                                                                                                     \
+        using P = detail::Pack<T, W>;                                                                                     \
+        detail::Apply<T, W>(x, y, n, [](P::V v) {                                                                         \
+            return detail::Fallback<T, P::V, P::I>(v, detail::Cos<T, P::V, P::I>(v), detail::Constants<T>::TrigMax,      \
+                [](T u) { return std::cos(u); });                                                                         \
+        });                                                                                                               \
+    }                                                                                                                     \
+    void Tan(T const* x, T* y, size_t n) noexcept                                                                         \
+    {                                                                                                                     \
+        using P = detail::Pack<T, W>;                                                                                     \
+        detail::Apply<T, W>(x, y, n, [](P::V v) {                                                                         \
+            return detail::Fallback<T, P::V, P::I>(v, detail::Tan<T, P::V, P::I>(v), detail::Constants<T>::TrigMax,      \
+                [](T u) { return std::tan(u); });                                                                         \
+        });                                                                                                               \
+    }                                                                                                                     \
+    void Cbrt(T const* x, T* y, size_t n) noexcept                                                                        \
+    {                                                                                                                     \
+        using P = detail::Pack<T, W>;                                                                                     \
+        detail::Apply<T, W>(x, y, n, [](P::V v) { return detail::Cbrt<T, P::V, P::I>(v); });                              \
+    }
+#endif
+} // namespace Operon::VectorMath
+
+#endif
@@ -23,7 +23,11 @@
 #include <pybind11/eigen.h>
 #include <pybind11/functional.h>
 
+#include <cstdint>
 #include <gsl/span>
+#include <limits>
+#include <memory>
+#include <string_view>
 
 #include "core/dataset.hpp"
 
@@ -31,6 +35,50 @@
 
 namespace py = pybind11;
 
+// the Arrow C data interface (https://arrow.apache.org/docs/format/CDataInterface.html), an ABI-stable description of
+// columnar data, declared as the specification recommends to avoid clashing with other declarations
+#ifndef ARROW_C_DATA_INTERFACE
+#define ARROW_C_DATA_INTERFACE
+
+#define ARROW_FLAG_DICTIONARY_ORDERED 1
+#define ARROW_FLAG_NULLABLE 2
+#define ARROW_FLAG_MAP_KEYS_SORTED 4
+
+struct ArrowSchema {
+    const char* format;
+    const char* name;
+    const char* metadata;
+    int64_t flags;
+    int64_t n_children;
+    struct ArrowSchema** children;
+    struct ArrowSchema* dictionary;
+    void (*release)(struct ArrowSchema*);
+    void* private_data;
+};
+
+struct ArrowArray {
+    int64_t length;
+    int64_t null_count;
+    int64_t offset;
+    int64_t n_buffers;
+    int64_t n_children;
+    const void** buffers;
+    struct ArrowArray** children;
+    struct ArrowArray* dictionary;
+    void (*release)(struct ArrowArray*);
+    void* private_data;
+};
+#endif
+
+namespace {
+// the python objects backing a column view are released with the gil held, whichever thread drops the last copy of the dataset
+template<typename T>
+std::shared_ptr<T> MakeOwner()
+{
+    return std::shared_ptr<T>(new T, [](T* p) { py::gil_scoped_acquire gil; delete p; });
+}
+} // namespace
+
 template<typename T>
 Operon::Dataset MakeDataset(py::array_t<T> array)
 {
@@ -86,6 +134,104 @@ Operon::Dataset MakeDataset(py::buffer buf)
     }
 }
 
+// a view over a dict of one-dimensional columns (eg. numpy arrays, or the series of a data frame with dict(df)): the
+// contiguous columns in the storage precision are used in place, the others are converted
+Operon::Dataset MakeDataset(py::dict const& dict)
+{
+    auto arrays = MakeOwner<std::vector<py::array>>();
+    std::vector<std::string> names;
+    std::vector<Operon::Scalar const*> columns;
+    size_t rows = 0;
+
+    for (auto [key, value] : dict) {
+        auto name = py::str(key).cast<std::string>();
+        auto array = py::array_t<Operon::Scalar, py::array::c_style | py::array::forcecast>::ensure(value);
+        if (!array) {
+            throw std::runtime_error(fmt::format("Column {} cannot be converted to numbers.\n", name));
+        }
+        if (array.ndim() != 1) {
+            throw std::runtime_error("The columns must have exactly one dimension.\n");
+        }
+        if (!columns.empty() && static_cast<size_t>(array.size()) != rows) {
+            throw std::runtime_error("The columns must have the same length.\n");
+        }
+        rows = static_cast<size_t>(array.size());
+        names.push_back(name);
+        columns.push_back(array.data());
+        arrays->push_back(std::move(array));
+    }
+    return Operon::Dataset(names, std::move(columns), rows, std::move(arrays));
+}
+
+// a record batch (or struct array) exported through the Arrow PyCapsule interface (__arrow_c_array__, eg. by pyarrow):
+// the columns in the storage precision without nulls are used in place, the other numeric columns are converted (the
+// nulls becoming nan)
+Operon::Dataset MakeDataset(py::object const& batch)
+{
+    if (!py::hasattr(batch, "__arrow_c_array__")) {
+        throw py::type_error("Expected a dict of columns or an object implementing the Arrow PyCapsule interface (__arrow_c_array__).");
+    }
+    auto capsules = batch.attr("__arrow_c_array__")().cast<py::tuple>();
+    auto* schema = static_cast<ArrowSchema*>(PyCapsule_GetPointer(capsules[0].ptr(), "arrow_schema"));
+    auto* exported = static_cast<ArrowArray*>(PyCapsule_GetPointer(capsules[1].ptr(), "arrow_array"));
+    if (schema == nullptr || exported == nullptr) {
+        throw py::error_already_set();
+    }
+    if (std::string_view(schema->format) != "+s") {
+        throw std::runtime_error("Expected a record batch or a struct array.\n");
+    }
+
+    // the array is moved out of its capsule, which does not release a moved array
+    struct Owner {
+        ArrowArray Array {};
+        std::vector<std::vector<Operon::Scalar>> Converted;
+
+        ~Owner() { if (Array.release != nullptr) { Array.release(&Array); } }
+    };
+    auto owner = MakeOwner<Owner>();
+    owner->Array = *exported;
+    exported->release = nullptr;
+
+    auto const& array = owner->Array;
+    auto rows = static_cast<size_t>(array.length);
+    std::vector<std::string> names;
+    std::vector<Operon::Scalar const*> columns;
+
+    for (int64_t i = 0; i < schema->n_children; ++i) {
+        auto const* field = schema->children[i];
+        auto const* child = array.children[i];
+        auto offset = static_cast<size_t>(array.offset + child->offset);
+        auto const* validity = child->null_count != 0 ? static_cast<uint8_t const*>(child->buffers[0]) : nullptr;
+        auto format = std::string_view(field->format);
+        names.emplace_back(field->name != nullptr ? field->name : fmt::format("X{}", i + 1));
+
+        if (format == (std::is_same_v<Operon::Scalar, double> ? "g" : "f") && validity == nullptr) {
+            columns.push_back(static_cast<Operon::Scalar const*>(child->buffers[1]) + offset);
+            continue;
+        }
+        auto& values = owner->Converted.emplace_back(rows);
+        auto convert = [&](auto const* data) {
+            for (size_t j = 0; j < rows; ++j) {
+                auto k = offset + j;
+                bool valid = validity == nullptr || ((validity[k / 8] >> (k % 8)) & 1);
+                values[j] = valid ? static_cast<Operon::Scalar>(data[k]) : std::numeric_limits<Operon::Scalar>::quiet_NaN();
+            }
+        };
+        if (format == "g") {
+            convert(static_cast<double const*>(child->buffers[1]));
+        } else if (format == "f") {
+            convert(static_cast<float const*>(child->buffers[1]));
+        } else if (format == "l") {
+            convert(static_cast<int64_t const*>(child->buffers[1]));
+        } else if (format == "i") {
+            convert(static_cast<int32_t const*>(child->buffers[1]));
+        } else {
+            throw std::runtime_error(fmt::format("Column {} has an unsupported type (format {}).\n", names.back(), format));
+        }
+        columns.push_back(values.data());
+    }
+    return Operon::Dataset(names, std::move(columns), rows, std::move(owner));
+}
 
 void init_dataset(py::module_ &m)
 {
@@ -99,10 +245,13 @@ void init_dataset(py::module_ &m)
         .def(py::init([](std::vector<std::vector<float>> const& values) { return MakeDataset(values); }), py::arg("data").noconvert())
         .def(py::init([](std::vector<std::vector<double>> const& values) { return MakeDataset(values); }), py::arg("data").noconvert())
         .def(py::init([](py::buffer buf) { return MakeDataset(buf); }), py::arg("data").noconvert())
+        .def(py::init([](py::dict const& columns) { return MakeDataset(columns); }), py::arg("columns"))
+        .def(py::init([](py::object const& batch) { return MakeDataset(batch); }), py::arg("batch"))
         .def_property_readonly("Rows", &Operon::Dataset::Rows)
         .def_property_readonly("Cols", &Operon::Dataset::Cols)
         .def_property_readonly("Values", &Operon::Dataset::Values)
         .def_property("VariableNames", &Operon::Dataset::VariableNames, &Operon::Dataset::SetVariableNames)
+        .def_property("ChunkSize", &Operon::Dataset::ChunkSize, &Operon::Dataset::SetChunkSize)
         .def("GetValues", [](Operon::Dataset const& self, std::string const& name) { return MakeView(self.GetValues(name)); })
         .def("GetValues", [](Operon::Dataset const& self, Operon::Hash hash) { return MakeView(self.GetValues(hash)); })
         .def("GetValues", [](Operon::Dataset const& self, int index) { return MakeView(self.GetValues(index)); })
@@ -103,6 +103,11 @@ void init_eval(py::module_ &m)
     py::class_<Operon::EvaluatorBase>(m, "EvaluatorBase")
         .def_property("LocalOptimizationIterations", &Operon::EvaluatorBase::GetLocalOptimizationIterations, &Operon::EvaluatorBase::SetLocalOptimizationIterations)
         .def_property("Budget",&Operon::EvaluatorBase::GetBudget, &Operon::EvaluatorBase::SetBudget)
+        .def_property("Simplification", &Operon::EvaluatorBase::GetSimplification, &Operon::EvaluatorBase::SetSimplification)
+        .def_property("BatchSize", &Operon::EvaluatorBase::GetBatchSize, &Operon::EvaluatorBase::SetBatchSize)
+        .def_property("IntervalPrescreening", &Operon::EvaluatorBase::GetIntervalPrescreening, &Operon::EvaluatorBase::SetIntervalPrescreening)
+        .def("SetSampleSize", &Operon::EvaluatorBase::SetSampleSize)
+        .def_property_readonly("IsSampling", &Operon::EvaluatorBase::IsSampling)
         .def_property_readonly("FitnessEvaluations", &Operon::EvaluatorBase::FitnessEvaluations)
         .def_property_readonly("LocalEvaluations", &Operon::EvaluatorBase::LocalEvaluations)
         .def_property_readonly("TotalEvaluations", &Operon::EvaluatorBase::TotalEvaluations);
@@ -10,6 +10,7 @@ void init_generator(py::module_ &m)
     py::class_<Operon::BasicOffspringGenerator, Operon::OffspringGeneratorBase>(m, "BasicOffspringGenerator")
         .def(py::init<Operon::EvaluatorBase&, Operon::CrossoverBase&, Operon::MutatorBase&,
                 Operon::SelectorBase&, Operon::SelectorBase&>())
+        .def_property("DeferredEvaluation", &Operon::BasicOffspringGenerator::DeferredEvaluation, &Operon::BasicOffspringGenerator::SetDeferredEvaluation)
         .def("__call__", &Operon::BasicOffspringGenerator::operator(),
             py::arg("rng"),
             py::arg("crossover_probability"),
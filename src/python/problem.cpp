@@ -4,6 +4,10 @@
 
 void init_problem(py::module_ &m)
 {
+    py::enum_<Operon::Precision>(m, "Precision")
+        .value("Single", Operon::Precision::Single)
+        .value("Double", Operon::Precision::Double);
+
     // problem
     py::class_<Operon::Problem>(m, "Problem")
         .def(py::init([](Operon::Dataset const& ds, std::vector<Operon::Variable> const& variables, std::string const& target,
@@ -11,5 +15,9 @@ void init_problem(py::module_ &m)
             gsl::span<const Operon::Variable> vars(variables.data(), variables.size());
             return Operon::Problem(ds).Inputs(variables).Target(target).TrainingRange(trainingRange).TestRange(testRange);
         }))
+        .def_property("Precision", &Operon::Problem::GetPrecision, &Operon::Problem::SetPrecision)
+        .def_property("TrainingRows",
+            [](Operon::Problem const& self) { auto rows = self.TrainingRows(); return std::vector<size_t>(rows.begin(), rows.end()); },
+            [](Operon::Problem& self, std::vector<size_t> rows) { self.TrainingRows(std::move(rows)); })
         .def_property_readonly("PrimitiveSet", [](Operon::Problem& self) { return self.GetPrimitiveSet(); });
 }
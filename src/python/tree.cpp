@@ -13,7 +13,7 @@ void init_tree(py::module_ &m)
         .def("Sort", &Operon::Tree::Sort)
         .def("Hash", static_cast<Operon::Tree& (Operon::Tree::*)(Operon::HashFunction, Operon::HashMode)>(&Operon::Tree::Hash))
         .def("Reduce", &Operon::Tree::Reduce)
-        //.def("Simplify", &Operon::Tree::Simplify) // not yet implemented
+        .def("Simplify", &Operon::Tree::Simplify)
         .def("ChildIndices", &Operon::Tree::ChildIndices)
         .def("SetEnabled", &Operon::Tree::SetEnabled)
         .def("SetCoefficients", &Operon::Tree::SetCoefficients)
@@ -91,10 +91,12 @@ namespace Operon {
             qq += dd * dd / (nn * (nn - 1));
         }
 
-        s = ss.sum();
-        n = nn.sum();
-
-        q = Combine(nn, ss, qq);
+        // merge with the previously accumulated statistics
+        MeanVarianceCalculator part;
+        part.s = ss.sum();
+        part.n = nn.sum();
+        part.q = Combine(nn, ss, qq);
+        Add(part);
 
         // deal with remaining values
         if (sz < values.size()) {
@@ -69,14 +69,17 @@ namespace Operon {
             _sumY += yy;
         }
 
-        sumWe = _sumWe.sum();
-        sumX  = _sumX.sum();
-        sumY  = _sumY.sum();
+        // merge with the previously accumulated statistics
+        PearsonsRCalculator part;
+        part.sumWe = _sumWe.sum();
+        part.sumX  = _sumX.sum();
+        part.sumY  = _sumY.sum();
 
         auto [sxx, syy, sxy] = Combine(_sumWe, _sumX, _sumY, _sumXX, _sumYY, _sumXY);
-        sumXX = sxx;
-        sumYY = syy;
-        sumXY = sxy;
+        part.sumXX = sxx;
+        part.sumYY = syy;
+        part.sumXY = sxy;
+        Add(part);
 
         if (sz < x.size()) {
             Add(x.subspan(sz, x.size() - sz), y.subspan(sz, y.size() - sz));
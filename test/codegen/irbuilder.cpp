@@ -1,6 +1,154 @@
-#include <catch2/catch.hpp>
+/* This file is part of:
+ * Operon - Large Scale Genetic Programming Framework
+ *
+ * Licensed under the ISC License <https://opensource.org/licenses/ISC>
+ * Copyright (C) 2020 Bogdan Burlacu
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+ * REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+ * INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+ * LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+ * OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+ * PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include <doctest/doctest.h>
 
 #include "codegen/generator.hpp"
+#include "core/dataset.hpp"
+#include "core/eval.hpp"
+#include "core/pset.hpp"
+#include "operators/creator.hpp"
+#include "operators/evaluator.hpp"
+
+namespace Operon {
+namespace Test {
+TEST_CASE("Codegen from tree")
+{
+    size_t n = 100;
+    size_t maxLength = 50;
+    size_t maxDepth = 1000;
+
+    Operon::RandomGenerator rd(1234);
+    auto ds = Dataset("../data/Poly-10.csv", true);
+
+    auto target = "Y";
+    auto variables = ds.Variables();
+    std::vector<Variable> inputs;
+    std::copy_if(variables.begin(), variables.end(), std::back_inserter(inputs), [&](const auto& v) { return v.Name != target; });
+
+    Range range = { 0, ds.Rows() };
+
+    PrimitiveSet pset;
+    pset.SetConfig(PrimitiveSet::Arithmetic | NodeType::Exp | NodeType::Log | NodeType::Sqrt | NodeType::Square);
+    std::uniform_int_distribution<size_t> sizeDistribution(1, maxLength);
+    auto creator = BalancedTreeCreator { pset, inputs };
+
+    std::vector<Operon::Scalar> expected(range.Size());
+    std::vector<Operon::Scalar> actual(range.Size());
+
+    auto check = [&](auto const& tree, Operon::Scalar const* parameters) {
+        Evaluate<Operon::Scalar>(Tape(tree, ds), range, gsl::span<Operon::Scalar>(expected), parameters);
+        for (size_t i = 0; i < range.Size(); ++i) {
+            CHECK(std::abs(actual[i] - expected[i]) <= 1e-6 * (1 + std::abs(expected[i])));
+        }
+    };
+
+    SUBCASE("Compiled code matches the interpreter")
+    {
+        CodeGen codegen;
+        for (size_t i = 0; i < n; ++i) {
+            auto tree = creator(rd, sizeDistribution(rd), 0, maxDepth);
+            REQUIRE(codegen.Evaluate(tree, ds, range, gsl::span<Operon::Scalar>(actual)));
+            check(tree, nullptr);
+
+            auto coefficients = tree.GetCoefficients();
+            std::transform(coefficients.begin(), coefficients.end(), coefficients.begin(), [](auto v) { return v * 0.5; });
+            REQUIRE(codegen.Evaluate(tree, ds, range, gsl::span<Operon::Scalar>(actual), coefficients.data()));
+            check(tree, coefficients.data());
+        }
+    }
+
+    SUBCASE("Compiled functions are cached by tree hash")
+    {
+        CodeGen codegen;
+
+        auto x1 = Node(NodeType::Variable, inputs[0].Hash);
+        auto x2 = Node(NodeType::Variable, inputs[1].Hash);
+        auto c = Node(NodeType::Constant);
+        auto add = Node(NodeType::Add);
+        auto sub = Node(NodeType::Sub);
+        auto mul = Node(NodeType::Mul);
+        x1.Value = 2;
+        x2.Value = 3;
+        c.Value = 0.5;
+
+        // same expression with the operands of the addition swapped: same hash, different node order
+        auto lhs = Tree({ c, x1, sub, x2, x1, mul, add }).UpdateNodes();
+        auto rhs = Tree({ x2, x1, mul, c, x1, sub, add }).UpdateNodes();
+
+        REQUIRE(codegen.Evaluate(lhs, ds, range, gsl::span<Operon::Scalar>(actual)));
+        check(lhs, nullptr);
+        CHECK(codegen.CacheSize() == 1);
+        CHECK(codegen.CacheMisses() == 1);
+
+        REQUIRE(codegen.Evaluate(rhs, ds, range, gsl::span<Operon::Scalar>(actual)));
+        check(rhs, nullptr);
+        CHECK(codegen.CacheSize() == 1);
+        CHECK(codegen.CacheHits() == 1);
+
+        // different coefficients do not require recompilation
+        lhs[0].Value = 1.5;
+        REQUIRE(codegen.Evaluate(lhs, ds, range, gsl::span<Operon::Scalar>(actual)));
+        check(lhs, nullptr);
+        CHECK(codegen.CacheHits() == 2);
+    }
+
+    SUBCASE("Least recently used functions are evicted")
+    {
+        size_t capacity = 10;
+        CodeGen codegen(capacity);
+
+        for (size_t i = 0; i < n; ++i) {
+            auto tree = creator(rd, sizeDistribution(rd), 0, maxDepth);
+            REQUIRE(codegen.Evaluate(tree, ds, range, gsl::span<Operon::Scalar>(actual)));
+            check(tree, nullptr);
+            CHECK(codegen.CacheSize() <= capacity);
+        }
+    }
+
+    SUBCASE("Batch evaluation uses the compiled code")
+    {
+        Range training { 0, 250 };
+        Problem problem(ds, inputs, *ds.GetVariable(target), training, Range { 250, 500 });
+        auto targetValues = ds.GetValues(target).subspan(training.Start(), training.Size());
+
+        std::vector<Individual> individuals(n);
+        for (auto& ind : individuals) {
+            ind.Genotype = creator(rd, sizeDistribution(rd), 0, maxDepth);
+        }
+
+        MeanSquaredErrorEvaluator evaluator(problem);
+        evaluator.SetLocalOptimizationIterations(0);
+
+        auto& codegen = CodeGen::Instance();
+        auto lookups = codegen.CacheHits() + codegen.CacheMisses();
+        std::vector<Operon::Scalar> batch(n);
+        evaluator.EvaluateBatch(rd, individuals, batch);
+        CHECK(codegen.CacheHits() + codegen.CacheMisses() == lookups + n);
 
-TEST_CASE("Codegen from tree") {
+        // the scores match the interpreter
+        for (size_t i = 0; i < n; ++i) {
+            Evaluate<Operon::Scalar>(Tape(individuals[i].Genotype, ds), training, gsl::span<Operon::Scalar>(expected).subspan(0, training.Size()));
+            auto fitness = evaluator.Score(gsl::span<Operon::Scalar const>(expected).subspan(0, training.Size()), targetValues);
+            CHECK(batch[i] == doctest::Approx(fitness).epsilon(1e-6));
+        }
+    }
 }
+} // namespace Test
+} // namespace Operon
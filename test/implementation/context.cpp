@@ -0,0 +1,161 @@
+/* This file is part of:
+ * Operon - Large Scale Genetic Programming Framework
+ *
+ * Licensed under the ISC License <https://opensource.org/licenses/ISC>
+ * Copyright (C) 2020 Bogdan Burlacu
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+ * REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+ * INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+ * LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+ * OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+ * PERFORMANCE OF THIS SOFTWARE.
+ */
+
+
+#include <doctest/doctest.h>
+
+#include <execution>
+
+#include "core/dataset.hpp"
+#include "core/eval.hpp"
+#include "core/pset.hpp"
+#include "operators/creator.hpp"
+
+namespace Operon::Test {
+TEST_CASE("Evaluation context")
+{
+    size_t n = 1000;
+    size_t maxLength = 100;
+    size_t maxDepth = 1000;
+
+    Operon::RandomGenerator rd(1234);
+    auto ds = Dataset("../data/Poly-10.csv", true);
+
+    auto variables = ds.Variables();
+    std::vector<Variable> inputs;
+    std::copy_if(variables.begin(), variables.end(), std::back_inserter(inputs), [&](const auto& v) { return v.Name != "Y"; });
+
+    PrimitiveSet pset;
+    pset.SetConfig(PrimitiveSet::Arithmetic | NodeType::Exp | NodeType::Log);
+    std::uniform_int_distribution<size_t> sizeDistribution(1, maxLength);
+    auto creator = BalancedTreeCreator { pset, inputs };
+
+    std::vector<Tree> trees(n);
+    std::generate(trees.begin(), trees.end(), [&]() { return creator(rd, sizeDistribution(rd), 0, maxDepth); });
+
+    Range range { 0, 250 };
+    std::vector<Operon::Scalar> expected(range.Size());
+    std::vector<Operon::Scalar> actual(range.Size());
+
+    SUBCASE("a reused context gives the same values as a fresh one")
+    {
+        EvaluationContext<Operon::Scalar> context;
+        for (auto const& tree : trees) {
+            EvaluationContext<Operon::Scalar> fresh;
+            Evaluate<Operon::Scalar>(tree, ds, range, gsl::span<Operon::Scalar>(expected), nullptr, fresh);
+            Evaluate<Operon::Scalar>(tree, ds, range, gsl::span<Operon::Scalar>(actual), nullptr, context);
+            CHECK(std::equal(actual.begin(), actual.end(), expected.begin()));
+        }
+    }
+
+    SUBCASE("buffers stop growing once the largest tree was evaluated")
+    {
+        auto& context = EvaluationContext<Operon::Scalar>::Default();
+        for (auto const& tree : trees) {
+            Evaluate<Operon::Scalar>(tree, ds, range, gsl::span<Operon::Scalar>(actual));
+        }
+        auto const* buffer = context.Primal(0).data();
+        auto const columns = context.Primal(0).cols();
+        for (auto const& tree : trees) {
+            Evaluate<Operon::Scalar>(tree, ds, range, gsl::span<Operon::Scalar>(actual));
+        }
+        CHECK(context.Primal(0).data() == buffer);
+        CHECK(context.Primal(0).cols() == columns);
+    }
+
+    SUBCASE("fused leaves")
+    {
+        // all the unary functions, and constants next to the variables
+        PrimitiveSet full;
+        full.SetConfig(PrimitiveSet::Arithmetic | NodeType::Exp | NodeType::Log | NodeType::Sin | NodeType::Cos | NodeType::Tan | NodeType::Sqrt | NodeType::Cbrt | NodeType::Square);
+        auto fullCreator = BalancedTreeCreator { full, inputs };
+        for (size_t i = 0; i < n; ++i) {
+            auto tree = fullCreator(rd, sizeDistribution(rd), 0, maxDepth);
+            for (auto& node : tree.Nodes()) {
+                if (node.IsVariable() && std::bernoulli_distribution(0.3)(rd)) {
+                    node = Node(NodeType::Constant);
+                    node.Value = std::uniform_real_distribution<Operon::Scalar>(-2, 2)(rd);
+                }
+            }
+            trees.push_back(tree.UpdateNodes());
+        }
+
+        size_t fusedVariables { 0 };
+        size_t fusedConstants { 0 };
+        std::vector<size_t> rows;
+        for (size_t row = 0; row < 1000; row += 3) {
+            rows.push_back(row);
+        }
+        std::vector<Operon::Scalar> gathered(rows.size());
+        std::vector<Operon::Scalar> unfused(rows.size());
+        std::vector<float> single(range.Size());
+        std::vector<float> singleUnfused(range.Size());
+
+        for (auto const& tree : trees) {
+            // without column reuse every instruction writes its own column, so no leaf is fused
+            Tape tape(tree, ds);
+            Tape plain(tree, ds, /* reuseColumns */ false);
+            auto instructions = tape.Instructions();
+            fusedVariables += static_cast<size_t>(std::count_if(instructions.begin(), instructions.end(), [](auto const& instr) { return instr.Fused && instr.Opcode == NodeType::Variable; }));
+            fusedConstants += static_cast<size_t>(std::count_if(instructions.begin(), instructions.end(), [](auto const& instr) { return instr.Fused && instr.Opcode == NodeType::Constant; }));
+            CHECK(std::none_of(plain.Instructions().begin(), plain.Instructions().end(), [](auto const& instr) { return instr.Fused || instr.FusedArguments != 0; }));
+
+            Evaluate<Operon::Scalar>(tape, range, gsl::span<Operon::Scalar>(actual));
+            Evaluate<Operon::Scalar>(plain, range, gsl::span<Operon::Scalar>(expected));
+            CHECK(actual == expected);
+
+            Evaluate<Operon::Scalar>(tape, rows, gsl::span<Operon::Scalar>(gathered));
+            Evaluate<Operon::Scalar>(plain, rows, gsl::span<Operon::Scalar>(unfused));
+            CHECK(gathered == unfused);
+
+            Evaluate<float>(tape, range, gsl::span<float>(single));
+            Evaluate<float>(plain, range, gsl::span<float>(singleUnfused));
+            CHECK(single == singleUnfused);
+        }
+        CHECK(fusedVariables > 0);
+        CHECK(fusedConstants > 0);
+    }
+
+    SUBCASE("parallel evaluation over row chunks")
+    {
+        Range all { 0, ds.Rows() };
+        size_t chunkSize = 64;
+
+        auto evaluate = [&](Tree const& tree) {
+            std::vector<Operon::Scalar> values(all.Size());
+            std::vector<Operon::Scalar> chunked(all.Size());
+            Tape tape(tree, ds);
+            Evaluate<Operon::Scalar>(tape, all, gsl::span<Operon::Scalar>(values));
+            EvaluateParallel<Operon::Scalar>(tape, all, gsl::span<Operon::Scalar>(chunked), nullptr, chunkSize);
+            auto batched = Evaluate<Operon::Scalar>(tree, ds, all, size_t { 100 });
+            auto parallel = Evaluate<Operon::Scalar>(tree, ds, all, size_t { 100 }, nullptr, true);
+            return values == chunked && std::equal(values.begin(), values.end(), batched.begin()) && std::equal(values.begin(), values.end(), parallel.begin());
+        };
+
+        for (size_t i = 0; i < 100; ++i) {
+            CHECK(evaluate(trees[i]));
+        }
+
+        // nested in a parallel loop (the isolated inner loops give the same values)
+        std::vector<int> equal(trees.size());
+        std::transform(std::execution::par_unseq, trees.begin(), trees.end(), equal.begin(), evaluate);
+        CHECK(std::all_of(equal.begin(), equal.end(), [](auto v) { return v; }));
+    }
+}
+} // namespace Operon::Test
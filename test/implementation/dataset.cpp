@@ -0,0 +1,285 @@
+/* This file is part of:
+ * Operon - Large Scale Genetic Programming Framework
+ *
+ * Licensed under the ISC License <https://opensource.org/licenses/ISC>
+ * Copyright (C) 2020 Bogdan Burlacu
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+ * REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+ * INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+ * LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+ * OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+ * PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include <doctest/doctest.h>
+
+#include <filesystem>
+#include <fmt/core.h>
+#include <fstream>
+
+#include "core/dataset.hpp"
+#include "core/eval.hpp"
+
+namespace Operon::Test {
+TEST_CASE("Binary dataset format")
+{
+    auto csv = Dataset("../data/Poly-10.csv", true);
+    auto path = (std::filesystem::temp_directory_path() / "operon-poly-10.bin").string();
+    csv.WriteBinary(path);
+
+    CHECK(Dataset::IsBinary(path));
+    CHECK(!Dataset::IsBinary("../data/Poly-10.csv"));
+
+    SUBCASE("round trip")
+    {
+        auto ds = Dataset(path);
+        CHECK(ds.Dimensions() == csv.Dimensions());
+        CHECK((ds.Values() == csv.Values()).all());
+        for (auto const& v : csv.Variables()) {
+            auto w = ds.GetVariable(v.Hash);
+            REQUIRE(w.has_value());
+            CHECK(w->Name == v.Name);
+            CHECK(w->Index == v.Index);
+            auto a = ds.GetValues(v.Hash);
+            auto b = csv.GetValues(v.Hash);
+            CHECK(std::equal(a.begin(), a.end(), b.begin(), b.end()));
+            CHECK(ds.GetBounds(v.Hash).Lower == csv.GetBounds(v.Hash).Lower);
+            CHECK(ds.GetBounds(v.Hash).Upper == csv.GetBounds(v.Hash).Upper);
+        }
+    }
+
+    SUBCASE("the mapped values are read-only and outlive the dataset")
+    {
+        Operon::RandomGenerator rd(1234);
+        auto ds = Dataset(path);
+        CHECK_THROWS(ds.Shuffle(rd));
+
+        auto copy = std::make_unique<Dataset>(ds);
+        ds = Dataset("../data/Poly-10.csv", true);
+        CHECK((copy->Values() == csv.Values()).all());
+
+        // a copy of a dataset owning its values does not alias them
+        auto owned = ds;
+        CHECK(owned.Values().data() != ds.Values().data());
+        CHECK_NOTHROW(owned.Shuffle(rd));
+    }
+
+    SUBCASE("streamed evaluation")
+    {
+        auto ds = Dataset(path);
+        CHECK(ds.ChunkSize() > 0);
+        CHECK(csv.ChunkSize() == 0);
+        ds.SetChunkSize(123);
+
+        auto x = *csv.GetVariable("X1");
+        auto y = *csv.GetVariable("X2");
+        Tree tree({ Node(NodeType::Variable, y.Hash), Node(NodeType::Variable, x.Hash), Node(NodeType::Exp), Node(NodeType::Mul) });
+        tree.UpdateNodes();
+
+        Range range { 10, csv.Rows() };
+        auto expected = Evaluate<Operon::Scalar>(tree, csv, range);
+        std::vector<Operon::Scalar> actual(range.Size());
+        Evaluate<Operon::Scalar>(tree, ds, range, gsl::span<Operon::Scalar>(actual));
+        CHECK(std::equal(actual.begin(), actual.end(), expected.begin(), expected.end()));
+
+        size_t chunks { 0 };
+        size_t rows { 0 };
+        ForEachChunk(ds, range, [&](Range chunk) { ++chunks; rows += chunk.Size(); CHECK(chunk.Size() <= 123); });
+        CHECK(chunks == (range.Size() + 122) / 123);
+        CHECK(rows == range.Size());
+
+        auto segment = ds.GetValues(x.Hash, Range { 5, 15 });
+        CHECK(segment.size() == 10);
+        CHECK(segment.data() == ds.GetValues(x.Hash).data() + 5);
+    }
+
+    SUBCASE("invalid files")
+    {
+        auto truncated = (std::filesystem::temp_directory_path() / "operon-truncated.bin").string();
+        std::vector<char> bytes(100);
+        std::ifstream(path, std::ios::binary).read(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+        std::ofstream(truncated, std::ios::binary).write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+        CHECK_THROWS(Dataset { truncated });
+        std::filesystem::remove(truncated);
+    }
+
+    std::filesystem::remove(path);
+}
+
+TEST_CASE("Variable lookup")
+{
+    auto ds = Dataset("../data/Poly-10.csv", true);
+    auto check = [](Dataset const& d) {
+        for (auto const& v : d.Variables()) {
+            auto w = d.GetVariable(v.Hash);
+            REQUIRE(w.has_value());
+            CHECK(w->Name == v.Name);
+            CHECK(d.GetValues(v.Hash).data() == d.GetValues(static_cast<int>(v.Index)).data());
+        }
+    };
+    check(ds);
+
+    // unknown variables are not confused with their neighbours in hash order
+    auto x = *ds.GetVariable("X1");
+    CHECK(!ds.GetVariable(x.Hash + 1).has_value());
+    CHECK(!ds.GetVariable("X11").has_value());
+    CHECK(ds.GetValues(x.Hash + 1).empty());
+    CHECK(!ds.GetBounds(x.Hash + 1).IsDefined());
+
+    // the same for the values converted to another precision
+    ds.AddPrecision(Precision::Single);
+    auto single = ds.GetValues<float>(x.Hash);
+    auto values = ds.GetValues(x.Hash);
+    REQUIRE(single.size() == values.size());
+    CHECK(single.front() == static_cast<float>(values.front()));
+    CHECK(single.back() == static_cast<float>(values.back()));
+    CHECK(ds.GetValues<float>(x.Hash + 1).empty());
+
+    auto copy = ds;
+    ds.SetVariableNames({ "A", "B", "C", "D", "E", "F", "G", "H", "I", "J", "K" });
+    check(ds);
+    check(copy);
+    CHECK(!ds.GetVariable("X1").has_value());
+    CHECK(ds.GetVariable("A")->Index == 0);
+    CHECK(copy.GetVariable("X1")->Index == 0);
+}
+
+TEST_CASE("Column view")
+{
+    auto ds = Dataset("../data/Poly-10.csv", true);
+
+    // the columns in another order than in the dataset
+    std::vector<std::string> names;
+    std::vector<Operon::Scalar const*> columns;
+    for (auto const& v : ds.Variables()) {
+        names.push_back(v.Name);
+        columns.push_back(ds.GetValues(v.Hash).data());
+    }
+    auto keepAlive = std::make_shared<int>(0);
+    std::weak_ptr<int> released = keepAlive;
+    auto view = std::make_unique<Dataset>(names, columns, ds.Rows(), std::move(keepAlive));
+
+    CHECK(view->Rows() == ds.Rows());
+    CHECK(view->Cols() == ds.Cols());
+    for (auto const& v : ds.Variables()) {
+        CHECK(view->GetValues(v.Hash).data() == ds.GetValues(v.Hash).data());
+        CHECK(view->GetBounds(v.Hash).Lower == ds.GetBounds(v.Hash).Lower);
+        CHECK(view->GetBounds(v.Hash).Upper == ds.GetBounds(v.Hash).Upper);
+    }
+
+    auto x = *ds.GetVariable("X1");
+    auto y = *ds.GetVariable("X2");
+    Tree tree({ Node(NodeType::Variable, y.Hash), Node(NodeType::Variable, x.Hash), Node(NodeType::Div) });
+    tree.UpdateNodes();
+    Range range { 0, ds.Rows() };
+    auto expected = Evaluate<Operon::Scalar>(tree, ds, range);
+    auto actual = Evaluate<Operon::Scalar>(tree, *view, range);
+    CHECK(std::equal(actual.begin(), actual.end(), expected.begin(), expected.end()));
+
+    view->AddPrecision(Precision::Single);
+    auto single = view->GetValues<float>(x.Hash);
+    auto values = ds.GetValues(x.Hash);
+    CHECK(std::equal(single.begin(), single.end(), values.begin(), values.end(), [](auto a, auto b) { return a == static_cast<float>(b); }));
+
+    Operon::RandomGenerator rd(1234);
+    CHECK_THROWS(view->Shuffle(rd));
+    CHECK_THROWS(view->Values());
+
+    // the columns can be written to the binary format like any other dataset
+    auto path = (std::filesystem::temp_directory_path() / "operon-columns.bin").string();
+    view->WriteBinary(path);
+    auto mapped = Dataset(path);
+    for (auto const& v : ds.Variables()) {
+        auto a = mapped.GetValues(v.Hash);
+        auto b = ds.GetValues(v.Hash);
+        CHECK(std::equal(a.begin(), a.end(), b.begin(), b.end()));
+    }
+    std::filesystem::remove(path);
+
+    auto copy = *view;
+    view.reset();
+    CHECK(!released.expired());
+    CHECK(copy.GetValues(x.Hash).data() == values.data());
+    copy = Dataset(ds);
+    CHECK(released.expired());
+}
+
+TEST_CASE("Csv parser")
+{
+    auto path = (std::filesystem::temp_directory_path() / "operon-parser.csv").string();
+    auto write = [&](std::string const& text) { std::ofstream(path, std::ios::binary) << text; };
+
+    SUBCASE("header, line endings and missing values")
+    {
+        write("A, \"B\",C\r\n1,+2.5, 3e-2\r\n-4,,nan\n\n  \n5,6,7");
+        auto ds = Dataset(path, true);
+        REQUIRE(ds.Rows() == 3);
+        REQUIRE(ds.Cols() == 3);
+        auto a = ds.GetValues("A");
+        auto b = ds.GetValues("B");
+        auto c = ds.GetValues("C");
+        std::vector<Operon::Scalar> expected { 1, -4, 5 };
+        CHECK(std::equal(a.begin(), a.end(), expected.begin(), expected.end()));
+        CHECK(b[0] == 2.5);
+        CHECK(std::isnan(b[1]));
+        CHECK(b[2] == 6);
+        CHECK(c[0] == Operon::Scalar(3e-2));
+        CHECK(std::isnan(c[1]));
+        CHECK(ds.GetVariable("C")->Index == 2);
+    }
+
+    SUBCASE("quoted header")
+    {
+        write("\"x, y\", \"say \"\"hi\"\"\" ,z\n1,2,3\n");
+        auto ds = Dataset(path, true);
+        REQUIRE(ds.Cols() == 3);
+        CHECK(ds.GetValues("x, y")[0] == 1);
+        CHECK(ds.GetValues("say \"hi\"")[0] == 2);
+        CHECK(ds.GetValues("z")[0] == 3);
+
+        auto read = [&]() { return Dataset(path, true); };
+        write("\"x,y\n1,2\n");
+        CHECK_THROWS(read());
+        write("\"x\"y,z\n1,2\n");
+        CHECK_THROWS(read());
+    }
+
+    SUBCASE("invalid rows")
+    {
+        write("1,2\n3\n");
+        CHECK_THROWS(Dataset { path });
+        write("1,2\n3,4,5\n");
+        CHECK_THROWS(Dataset { path });
+        write("1,2\n3,x\n");
+        CHECK_THROWS(Dataset { path });
+    }
+
+    SUBCASE("parallel chunks")
+    {
+        // large enough to be split into several chunks, the values are printed with round-trip precision
+        Operon::RandomGenerator rd(1234);
+        Dataset::Matrix values(20000, 7);
+        std::string text;
+        for (Eigen::Index i = 0; i < values.rows(); ++i) {
+            for (Eigen::Index j = 0; j < values.cols(); ++j) {
+                values(i, j) = std::uniform_real_distribution<Operon::Scalar>(-1e3, 1e3)(rd);
+                text += fmt::format(j == 0 ? "{}" : ",{}", values(i, j));
+            }
+            text += '\n';
+        }
+        write(text);
+        auto ds = Dataset(path);
+        CHECK(ds.Rows() == 20000);
+        CHECK(ds.Cols() == 7);
+        CHECK((ds.Values() == values).all());
+    }
+
+    std::filesystem::remove(path);
+}
+} // namespace Operon::Test
@@ -0,0 +1,331 @@
+/* This file is part of:
+ * Operon - Large Scale Genetic Programming Framework
+ *
+ * Licensed under the ISC License <https://opensource.org/licenses/ISC>
+ * Copyright (C) 2020 Bogdan Burlacu
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+ * REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+ * INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+ * LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+ * OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+ * PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include <doctest/doctest.h>
+
+#include "core/dataset.hpp"
+#include "core/eval.hpp"
+#include "core/pset.hpp"
+#include "operators/creator.hpp"
+#include "operators/evaluator.hpp"
+
+namespace Operon::Test {
+TEST_CASE("Fused fitness evaluation")
+{
+    size_t n = 200;
+    size_t maxLength = 50;
+    size_t maxDepth = 1000;
+
+    Operon::RandomGenerator rd(1234);
+    auto ds = Dataset("../data/Poly-10.csv", true);
+
+    auto target = "Y";
+    auto variables = ds.Variables();
+    std::vector<Variable> inputs;
+    std::copy_if(variables.begin(), variables.end(), std::back_inserter(inputs), [&](const auto& v) { return v.Name != target; });
+
+    PrimitiveSet pset;
+    pset.SetConfig(PrimitiveSet::Arithmetic | NodeType::Exp | NodeType::Log);
+    std::uniform_int_distribution<size_t> sizeDistribution(1, maxLength);
+    auto creator = BalancedTreeCreator { pset, inputs };
+
+    Range range { 0, 250 };
+    Problem problem(ds, inputs, *ds.GetVariable(target), range, Range { 250, 500 });
+    auto targetValues = ds.GetValues(target).subspan(range.Start(), range.Size());
+
+    std::vector<Individual> individuals(n);
+    for (auto& ind : individuals) {
+        ind.Genotype = creator(rd, sizeDistribution(rd), 0, maxDepth);
+    }
+
+    // scores of the materialized estimated values
+    auto expected = [&](auto const& evaluator) {
+        std::vector<Operon::Scalar> fitness;
+        std::vector<Operon::Scalar> values(range.Size());
+        for (auto& ind : individuals) {
+            Evaluate<Operon::Scalar>(ind.Genotype, ds, range, gsl::span<Operon::Scalar>(values));
+            fitness.push_back(evaluator.Score(values, targetValues));
+        }
+        return fitness;
+    };
+
+    auto check = [&](auto&& evaluator) {
+        evaluator.SetLocalOptimizationIterations(0);
+        auto fitness = expected(evaluator);
+        for (size_t i = 0; i < n; ++i) {
+            CHECK(evaluator(rd, individuals[i]) == doctest::Approx(fitness[i]).epsilon(1e-6));
+        }
+        std::vector<Operon::Scalar> batch(n);
+        evaluator.EvaluateBatch(rd, individuals, batch);
+        for (size_t i = 0; i < n; ++i) {
+            CHECK(batch[i] == doctest::Approx(fitness[i]).epsilon(1e-6));
+        }
+    };
+
+    SUBCASE("mean squared error")
+    {
+        check(MeanSquaredErrorEvaluator(problem));
+    }
+
+    SUBCASE("normalized mean squared error")
+    {
+        check(NormalizedMeanSquaredErrorEvaluator(problem));
+    }
+
+    SUBCASE("r-squared")
+    {
+        check(RSquaredEvaluator(problem));
+    }
+
+    SUBCASE("runtime precision")
+    {
+        MeanSquaredErrorEvaluator evaluator(problem);
+        evaluator.SetLocalOptimizationIterations(0);
+
+        problem.SetPrecision(Precision::Single);
+        auto const& data = problem.GetDataset();
+        REQUIRE(data.HasPrecision(Precision::Single));
+        auto singleTarget = data.GetValues<float>(problem.TargetVariable()).subspan(range.Start(), range.Size());
+        for (size_t i = 0; i < range.Size(); ++i) {
+            CHECK(singleTarget[i] == static_cast<float>(targetValues[i]));
+        }
+
+        std::vector<Operon::Scalar> batch(n);
+        evaluator.EvaluateBatch(rd, individuals, batch);
+        std::vector<float> values(range.Size());
+        for (size_t i = 0; i < n; ++i) {
+            Evaluate<float>(individuals[i].Genotype, data, range, gsl::span<float>(values));
+            MeanSquaredErrorEvaluator::Calculator calculator;
+            MeanSquaredErrorEvaluator::Accumulate(calculator, gsl::span<float const>(values), singleTarget);
+            auto fitness = MeanSquaredErrorEvaluator::Score(calculator);
+            CHECK(evaluator(rd, individuals[i]) == doctest::Approx(fitness).epsilon(1e-6));
+            CHECK(batch[i] == doctest::Approx(fitness).epsilon(1e-6));
+        }
+
+        // back to the storage precision, eg. to re-score the final models
+        problem.SetPrecision(Dataset::StoragePrecision);
+        check(evaluator);
+    }
+
+    SUBCASE("bounded evaluation")
+    {
+        MeanSquaredErrorEvaluator evaluator(problem);
+        evaluator.SetLocalOptimizationIterations(0);
+        auto fitness = expected(evaluator);
+
+        // half of the valid individuals cannot beat their median
+        std::vector<Operon::Scalar> valid;
+        std::copy_if(fitness.begin(), fitness.end(), std::back_inserter(valid), [](auto f) { return f < MeanSquaredErrorEvaluator::UpperBound; });
+        REQUIRE(!valid.empty());
+        std::nth_element(valid.begin(), valid.begin() + static_cast<std::ptrdiff_t>(valid.size() / 2), valid.end());
+        auto bound = valid[valid.size() / 2];
+
+        size_t rejected { 0 };
+        for (size_t i = 0; i < n; ++i) {
+            auto f = evaluator.EvaluateBounded(rd, individuals[i], bound);
+            if (fitness[i] < bound) {
+                CHECK(f == doctest::Approx(fitness[i]).epsilon(1e-6));
+            } else {
+                CHECK(f == EvaluatorBase::RejectedFitness);
+                ++rejected;
+            }
+        }
+        CHECK(evaluator.RejectedEvaluations() == rejected);
+    }
+
+    SUBCASE("sampled training rows")
+    {
+        MeanSquaredErrorEvaluator evaluator(problem);
+        evaluator.SetLocalOptimizationIterations(0);
+        evaluator.SetSampleSize(100);
+        REQUIRE(evaluator.Resample(rd, 1));
+
+        auto sample = evaluator.Sample();
+        CHECK(sample.size() == 100);
+        CHECK(std::is_sorted(sample.begin(), sample.end()));
+        CHECK(std::adjacent_find(sample.begin(), sample.end()) == sample.end());
+        CHECK(sample.front() >= range.Start());
+        CHECK(sample.back() < range.End());
+
+        auto column = ds.GetValues(target);
+        std::vector<Operon::Scalar> sampleTarget;
+        std::transform(sample.begin(), sample.end(), std::back_inserter(sampleTarget), [&](auto row) { return column[row]; });
+
+        std::vector<Operon::Scalar> batch(n);
+        evaluator.EvaluateBatch(rd, individuals, batch);
+        std::vector<Operon::Scalar> values(sample.size());
+        for (size_t i = 0; i < n; ++i) {
+            Evaluate<Operon::Scalar>(individuals[i].Genotype, ds, sample, gsl::span<Operon::Scalar>(values));
+            auto fitness = evaluator.Score(values, sampleTarget);
+            CHECK(evaluator(rd, individuals[i]) == doctest::Approx(fitness).epsilon(1e-6));
+            CHECK(batch[i] == doctest::Approx(fitness).epsilon(1e-6));
+        }
+
+        // a sample of the whole training range is no sample
+        evaluator.SetSampleSize(range.Size());
+        CHECK(!evaluator.Resample(rd, 2));
+        CHECK(evaluator.Sample().empty());
+        check(evaluator);
+    }
+
+    SUBCASE("rescoring")
+    {
+        MeanSquaredErrorEvaluator evaluator(problem);
+        evaluator.SetLocalOptimizationIterations(10);
+        evaluator.SetSampleSize(100);
+        REQUIRE(evaluator.Resample(rd, 1));
+
+        std::vector<Operon::Scalar> batch(n);
+        evaluator.EvaluateBatch(rd, individuals, batch);
+        auto const fitnessEvaluations = evaluator.FitnessEvaluations();
+        auto const localEvaluations = evaluator.LocalEvaluations();
+        CHECK(localEvaluations > 0);
+
+        // the optimized individuals score the same on the same sample, without being optimized again
+        std::vector<Operon::Scalar> rescored(n);
+        evaluator.Rescore(rd, individuals, rescored);
+        for (size_t i = 0; i < n; ++i) {
+            CHECK(rescored[i] == doctest::Approx(batch[i]).epsilon(1e-6));
+        }
+        CHECK(evaluator.FitnessEvaluations() == fitnessEvaluations);
+        CHECK(evaluator.LocalEvaluations() == localEvaluations);
+        CHECK(evaluator.RescoredEvaluations() == n);
+
+        // rescoring on a new sample does not spend the budget either
+        REQUIRE(evaluator.Resample(rd, 2));
+        evaluator.Rescore(rd, individuals, rescored);
+        CHECK(evaluator.LocalEvaluations() == localEvaluations);
+        CHECK(evaluator.TotalEvaluations() == fitnessEvaluations + localEvaluations);
+        CHECK(evaluator.RescoredEvaluations() == 2 * n);
+    }
+
+    SUBCASE("training rows")
+    {
+        // the training set of the second of five cross-validation folds over the first 500 rows
+        std::vector<size_t> rows;
+        for (size_t row = 0; row < 500; ++row) {
+            if (row / 100 != 1) {
+                rows.push_back(row);
+            }
+        }
+        std::shuffle(rows.begin(), rows.end(), rd);
+        problem.TrainingRows(rows);
+        auto trainingRows = problem.TrainingRows();
+        REQUIRE(trainingRows.size() == rows.size());
+        CHECK(std::is_sorted(trainingRows.begin(), trainingRows.end()));
+        CHECK(problem.TrainingRange().Start() == 0);
+        CHECK(problem.TrainingRange().End() == 500);
+
+        auto column = ds.GetValues(target);
+        std::vector<Operon::Scalar> foldTarget;
+        std::transform(trainingRows.begin(), trainingRows.end(), std::back_inserter(foldTarget), [&](auto row) { return column[row]; });
+
+        RSquaredEvaluator evaluator(problem);
+        evaluator.SetLocalOptimizationIterations(0);
+        std::vector<Operon::Scalar> batch(n);
+        evaluator.EvaluateBatch(rd, individuals, batch);
+        std::vector<Operon::Scalar> values(trainingRows.size());
+        for (size_t i = 0; i < n; ++i) {
+            Evaluate<Operon::Scalar>(individuals[i].Genotype, ds, trainingRows, gsl::span<Operon::Scalar>(values));
+            auto fitness = evaluator.Score(values, foldTarget);
+            CHECK(evaluator(rd, individuals[i]) == doctest::Approx(fitness).epsilon(1e-6));
+            CHECK(batch[i] == doctest::Approx(fitness).epsilon(1e-6));
+        }
+
+        // samples are drawn from the training rows
+        evaluator.SetSampleSize(50);
+        REQUIRE(evaluator.Resample(rd, 1));
+        for (auto row : evaluator.Sample()) {
+            CHECK(std::binary_search(trainingRows.begin(), trainingRows.end(), row));
+        }
+
+        // the coefficients are fitted on the training rows
+        evaluator.ClearSample();
+        evaluator.SetLocalOptimizationIterations(10);
+        for (size_t i = 0; i < 10; ++i) {
+            auto ind = individuals[i];
+            auto before = evaluator(rd, ind);
+            Evaluate<Operon::Scalar>(ind.Genotype, ds, trainingRows, gsl::span<Operon::Scalar>(values));
+            CHECK(before == doctest::Approx(evaluator.Score(values, foldTarget)).epsilon(1e-6));
+        }
+
+        // setting a range drops the training rows
+        problem.TrainingRange(range);
+        CHECK(problem.TrainingRows().empty());
+    }
+
+    SUBCASE("batch sizes")
+    {
+        constexpr auto sizes = BatchSizes<Operon::Scalar>;
+        auto selected = [](size_t batchSize, size_t columns) { return WithBatchSize<Operon::Scalar>(batchSize, columns, [](auto s) { return decltype(s)::value; }); };
+        CHECK(selected(1, 0) == sizes.front());
+        CHECK(selected(sizes[2] + 1, 0) == sizes[2]);
+        CHECK(selected(sizes.back() * 2, 0) == sizes.back());
+
+        // the automatic batch size shrinks as the scratch buffer grows
+        for (size_t columns : { 1, 10, 100, 1000 }) {
+            auto s = AutomaticBatchSize<Operon::Scalar>(columns);
+            CHECK(std::find(sizes.begin(), sizes.end(), s) != sizes.end());
+            CHECK(selected(0, columns) == s);
+            CHECK(s <= AutomaticBatchSize<Operon::Scalar>(columns / 2));
+        }
+
+        MeanSquaredErrorEvaluator evaluator(problem);
+        for (auto batchSize : sizes) {
+            evaluator.SetBatchSize(batchSize);
+            check(evaluator);
+        }
+    }
+
+    SUBCASE("datasets streamed in chunks")
+    {
+        // chunks that are not a multiple of the batch size, with a partial last chunk
+        problem.GetDataset().SetChunkSize(97);
+        check(MeanSquaredErrorEvaluator(problem));
+        check(RSquaredEvaluator(problem));
+
+        MeanSquaredErrorEvaluator bounded(problem);
+        bounded.SetLocalOptimizationIterations(0);
+        auto fitness = expected(bounded);
+        for (size_t i = 0; i < n; ++i) {
+            auto bound = std::nextafter(fitness[i], std::numeric_limits<Operon::Scalar>::infinity());
+            CHECK(bounded.EvaluateBounded(rd, individuals[i], bound) == doctest::Approx(fitness[i]).epsilon(1e-6));
+        }
+    }
+
+    SUBCASE("statistics accumulated in batches")
+    {
+        auto values = ds.GetValues(inputs.front().Name).subspan(range.Start(), range.Size());
+
+        PearsonsRCalculator whole;
+        whole.Add(values, targetValues);
+
+        PearsonsRCalculator batches;
+        for (size_t i = 0; i < values.size(); i += 64) {
+            auto size = std::min(size_t { 64 }, values.size() - i);
+            batches.Add(values.subspan(i, size), targetValues.subspan(i, size));
+        }
+        CHECK(batches.Count() == whole.Count());
+        CHECK(batches.MeanX() == doctest::Approx(whole.MeanX()));
+        CHECK(batches.NaiveVarianceX() == doctest::Approx(whole.NaiveVarianceX()));
+        CHECK(batches.NaiveVarianceY() == doctest::Approx(whole.NaiveVarianceY()));
+        CHECK(batches.NaiveCovariance() == doctest::Approx(whole.NaiveCovariance()));
+    }
+}
+} // namespace Operon::Test
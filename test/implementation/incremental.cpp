@@ -0,0 +1,127 @@
+/* This file is part of:
+ * Operon - Large Scale Genetic Programming Framework
+ *
+ * Licensed under the ISC License <https://opensource.org/licenses/ISC>
+ * Copyright (C) 2020 Bogdan Burlacu
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+ * REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+ * INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+ * LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+ * OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+ * PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include <doctest/doctest.h>
+
+#include "core/dataset.hpp"
+#include "core/eval.hpp"
+#include "core/pset.hpp"
+#include "operators/creator.hpp"
+
+namespace Operon::Test {
+TEST_CASE("Incremental evaluation")
+{
+    size_t n = 100;
+    size_t generations = 20;
+    size_t maxLength = 100;
+    size_t maxDepth = 1000;
+
+    Operon::RandomGenerator rd(1234);
+    auto ds = Dataset("../data/Poly-10.csv", true);
+
+    auto target = "Y";
+    auto variables = ds.Variables();
+    std::vector<Variable> inputs;
+    std::copy_if(variables.begin(), variables.end(), std::back_inserter(inputs), [&](const auto& v) { return v.Name != target; });
+
+    PrimitiveSet pset;
+    pset.SetConfig(PrimitiveSet::Arithmetic | NodeType::Exp | NodeType::Log);
+    std::uniform_int_distribution<size_t> sizeDistribution(1, maxLength);
+    auto creator = BalancedTreeCreator { pset, inputs };
+
+    Range range { 0, 250 };
+    std::vector<Operon::Scalar> expected(range.Size());
+    std::vector<Operon::Scalar> actual(range.Size());
+
+    auto same = [&]() {
+        return std::equal(actual.begin(), actual.end(), expected.begin(), [](auto a, auto b) { return a == b || (std::isnan(a) && std::isnan(b)); });
+    };
+
+    // point changes of the kind performed by the one-point, change-variable and change-function mutations
+    auto mutate = [&](Tree& tree) {
+        auto& nodes = tree.Nodes();
+        auto& node = nodes[std::uniform_int_distribution<size_t>(0, nodes.size() - 1)(rd)];
+        if (node.IsVariable() && std::bernoulli_distribution(0.5)(rd)) {
+            node.HashValue = node.CalculatedHashValue = inputs[std::uniform_int_distribution<size_t>(0, inputs.size() - 1)(rd)].Hash;
+        } else if (node.IsLeaf()) {
+            node.Value += 0.5;
+        } else if (node.Arity == 2) {
+            auto symbol = pset.SampleRandomSymbol(rd, 2, 2);
+            node.Type = symbol.Type;
+            node.HashValue = node.CalculatedHashValue = symbol.HashValue;
+        }
+    };
+
+    SUBCASE("incremental values match the interpreter")
+    {
+        for (size_t i = 0; i < n; ++i) {
+            auto tree = creator(rd, sizeDistribution(rd), 0, maxDepth);
+            auto trace = EvaluateIncremental(tree, ds, range, gsl::span<Operon::Scalar>(actual));
+            for (size_t g = 0; g < generations; ++g) {
+                mutate(tree);
+                trace = EvaluateIncremental(tree, ds, range, gsl::span<Operon::Scalar>(actual), trace);
+                Evaluate<Operon::Scalar>(tree, ds, range, gsl::span<Operon::Scalar>(expected));
+                CHECK(same());
+            }
+        }
+    }
+
+    SUBCASE("unchanged subtrees share their columns")
+    {
+        auto tree = creator(rd, maxLength, 0, maxDepth);
+        auto parent = EvaluateIncremental(tree, ds, range, gsl::span<Operon::Scalar>(actual));
+
+        // changing a leaf only invalidates the path from the leaf to the root
+        auto& nodes = tree.Nodes();
+        auto leaf = std::find_if(nodes.begin(), nodes.end(), [](auto const& n) { return n.IsLeaf(); }) - nodes.begin();
+        nodes[leaf].Value += 1;
+        auto child = EvaluateIncremental(tree, ds, range, gsl::span<Operon::Scalar>(actual), parent);
+        Evaluate<Operon::Scalar>(tree, ds, range, gsl::span<Operon::Scalar>(expected));
+        CHECK(same());
+
+        size_t dirty = 0;
+        for (auto i = static_cast<size_t>(leaf);; i = nodes[i].Parent) {
+            ++dirty;
+            if (i == nodes.size() - 1) {
+                break;
+            }
+        }
+        size_t shared = 0;
+        for (size_t i = 0; i < nodes.size(); ++i) {
+            shared += child->Columns[i] == parent->Columns[i];
+        }
+        CHECK(shared == nodes.size() - dirty);
+
+        // an unchanged tree reuses the previous trace
+        CHECK(EvaluateIncremental(tree, ds, range, gsl::span<Operon::Scalar>(actual), child) == child);
+    }
+
+    SUBCASE("incompatible traces are ignored")
+    {
+        auto tree = creator(rd, maxLength, 0, maxDepth);
+        auto trace = EvaluateIncremental(tree, ds, range, gsl::span<Operon::Scalar>(actual));
+
+        auto other = creator(rd, maxLength / 2, 0, maxDepth);
+        EvaluateIncremental(other, ds, Range { 0, 100 }, gsl::span<Operon::Scalar>(actual), trace);
+        EvaluateIncremental(other, ds, range, gsl::span<Operon::Scalar>(actual), trace);
+        Evaluate<Operon::Scalar>(other, ds, range, gsl::span<Operon::Scalar>(expected));
+        CHECK(same());
+    }
+}
+} // namespace Operon::Test
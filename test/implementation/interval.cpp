@@ -0,0 +1,144 @@
+/* This file is part of:
+ * Operon - Large Scale Genetic Programming Framework
+ *
+ * Licensed under the ISC License <https://opensource.org/licenses/ISC>
+ * Copyright (C) 2020 Bogdan Burlacu
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+ * REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+ * INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+ * LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+ * OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+ * PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include <doctest/doctest.h>
+
+#include "core/dataset.hpp"
+#include "core/eval.hpp"
+#include "core/interval.hpp"
+#include "core/pset.hpp"
+#include "operators/creator.hpp"
+#include "operators/evaluator.hpp"
+
+namespace Operon::Test {
+TEST_CASE("Interval arithmetic")
+{
+    Interval a { -1, 2 };
+    Interval b { 1, 2 };
+
+    CHECK(!Log(a).IsDefined());
+    CHECK(!Sqrt(a).IsDefined());
+    CHECK(Log(b).Lower == 0);
+    CHECK(!(b / a).IsFinite());
+    CHECK((b / b).Lower == 0.5);
+    CHECK((b / b).Upper == 2);
+    CHECK((a * a).Lower == -2);
+    CHECK((a * a).Upper == 4);
+    CHECK(Square(a).Lower == 0);
+    CHECK(Square(a).Upper == 4);
+    CHECK((a - b).Lower == -3);
+    CHECK((a - b).Upper == 1);
+
+    // the extrema of the periodic functions are only included when the interval contains them
+    CHECK(Sin(Interval { 0, 1 }).Lower == 0);
+    CHECK(Sin(Interval { 0, 1 }).Upper == doctest::Approx(std::sin(1.0)));
+    CHECK(Sin(Interval { 0, 2 }).Upper == 1);
+    CHECK(Cos(Interval { 3, 4 }).Lower == -1);
+    CHECK(Cos(a).Upper == 1);
+    CHECK(Tan(Interval { -1, 1 }).IsFinite());
+    CHECK(!Tan(b).IsFinite());
+    CHECK(!Sin(Interval::Unbounded()).IsDefined());
+    CHECK(!(Interval::Undefined() * Interval::Point(0)).IsDefined());
+}
+
+TEST_CASE("Interval pre-screening")
+{
+    size_t n = 500;
+    size_t maxLength = 50;
+    size_t maxDepth = 1000;
+
+    Operon::RandomGenerator rd(1234);
+    auto ds = Dataset("../data/Poly-10.csv", true);
+
+    auto target = "Y";
+    auto variables = ds.Variables();
+    std::vector<Variable> inputs;
+    std::copy_if(variables.begin(), variables.end(), std::back_inserter(inputs), [&](const auto& v) { return v.Name != target; });
+
+    for (auto const& v : variables) {
+        auto values = ds.GetValues(v);
+        auto [min, max] = std::minmax_element(values.begin(), values.end());
+        auto bounds = ds.GetBounds(v);
+        CHECK(bounds.Lower == *min);
+        CHECK(bounds.Upper == *max);
+    }
+
+    PrimitiveSet pset;
+    pset.SetConfig(PrimitiveSet::Arithmetic | NodeType::Exp | NodeType::Log | NodeType::Sin | NodeType::Cos | NodeType::Tan | NodeType::Sqrt | NodeType::Cbrt | NodeType::Square);
+    std::uniform_int_distribution<size_t> sizeDistribution(1, maxLength);
+    auto creator = BalancedTreeCreator { pset, inputs };
+
+    Range range { 0, static_cast<size_t>(ds.Rows()) };
+    std::vector<Individual> individuals(n);
+    for (auto& ind : individuals) {
+        ind.Genotype = creator(rd, sizeDistribution(rd), 0, maxDepth);
+    }
+
+    SUBCASE("enclosure")
+    {
+        size_t finite { 0 };
+        std::vector<double> values(range.Size());
+        for (auto const& ind : individuals) {
+            auto bounds = EvaluateInterval(ind.Genotype, ds);
+            if (!bounds.IsFinite()) {
+                continue;
+            }
+            ++finite;
+            Evaluate<double>(ind.Genotype, ds, range, gsl::span<double>(values));
+            auto eps = 1e-6 * std::max(1.0, std::max(std::abs(bounds.Lower), std::abs(bounds.Upper)));
+            for (auto v : values) {
+                CHECK(std::isfinite(v));
+                CHECK(v >= bounds.Lower - eps);
+                CHECK(v <= bounds.Upper + eps);
+            }
+        }
+        CHECK(finite > 0);
+    }
+
+    SUBCASE("evaluator")
+    {
+        Problem problem(ds, inputs, *ds.GetVariable(target), Range { 0, 250 }, Range { 250, 500 });
+        MeanSquaredErrorEvaluator evaluator(problem);
+        evaluator.SetLocalOptimizationIterations(0);
+
+        std::vector<Operon::Scalar> fitness(n);
+        for (size_t i = 0; i < n; ++i) {
+            fitness[i] = evaluator(rd, individuals[i]);
+        }
+
+        evaluator.SetIntervalPrescreening(true);
+        evaluator.Reset();
+        size_t rejected { 0 };
+        std::vector<Operon::Scalar> batch(n);
+        evaluator.EvaluateBatch(rd, individuals, batch);
+        for (size_t i = 0; i < n; ++i) {
+            auto f = evaluator(rd, individuals[i]);
+            CHECK(f == batch[i]);
+            if (EvaluateInterval(individuals[i].Genotype, ds).IsFinite()) {
+                CHECK(f == doctest::Approx(fitness[i]).epsilon(1e-6));
+            } else {
+                CHECK(f == EvaluatorBase::RejectedFitness);
+                ++rejected;
+            }
+        }
+        CHECK(rejected > 0);
+        CHECK(evaluator.RejectedEvaluations() == 2 * rejected);
+    }
+}
+} // namespace Operon::Test
@@ -0,0 +1,136 @@
+/* This file is part of:
+ * Operon - Large Scale Genetic Programming Framework
+ *
+ * Licensed under the ISC License <https://opensource.org/licenses/ISC>
+ * Copyright (C) 2020 Bogdan Burlacu
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+ * REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+ * INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+ * LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+ * OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+ * PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include <doctest/doctest.h>
+
+#include "core/dataset.hpp"
+#include "core/eval.hpp"
+#include "core/pset.hpp"
+#include "nnls/tiny_optimizer.hpp"
+#include "operators/creator.hpp"
+
+namespace Operon::Test {
+TEST_CASE("Reverse-mode jacobian")
+{
+    size_t n = 100;
+    size_t maxLength = 100;
+    size_t maxDepth = 1000;
+
+    Operon::RandomGenerator rd(1234);
+    auto ds = Dataset("../data/Poly-10.csv", true);
+
+    auto target = "Y";
+    auto variables = ds.Variables();
+    std::vector<Variable> inputs;
+    std::copy_if(variables.begin(), variables.end(), std::back_inserter(inputs), [&](const auto& v) { return v.Name != target; });
+
+    Range range = { 0, 250 };
+    auto targetValues = ds.GetValues(target).subspan(range.Start(), range.Size());
+
+    PrimitiveSet pset;
+    std::uniform_int_distribution<size_t> sizeDistribution(1, maxLength);
+    auto creator = BalancedTreeCreator { pset, inputs };
+
+    // compares the residuals and the jacobian with the ones computed by forward-mode autodiff
+    // rows where the tree output is not finite are skipped (the two evaluation paths replace such values differently)
+    auto check = [&](double eps) {
+        for (size_t i = 0; i < n; ++i) {
+            auto tree = creator(rd, sizeDistribution(rd), 0, maxDepth);
+            auto parameters = tree.GetCoefficients();
+
+            TinyCostFunction<ResidualEvaluator, Dual, Eigen::ColMajor> forward(tree, ds, targetValues, range);
+            ReverseModeCostFunction<Eigen::ColMajor> reverse(tree, ds, targetValues, range);
+            REQUIRE(forward.NumParameters() == reverse.NumParameters());
+            REQUIRE(forward.NumResiduals() == reverse.NumResiduals());
+
+            auto rows = static_cast<size_t>(reverse.NumResiduals());
+            auto cols = static_cast<size_t>(reverse.NumParameters());
+            std::vector<Operon::Scalar> r1(rows), r2(rows), j1(rows * cols), j2(rows * cols);
+            REQUIRE(forward(parameters.data(), r1.data(), j1.data()));
+            REQUIRE(reverse(parameters.data(), r2.data(), j2.data()));
+
+            for (size_t row = 0; row < rows; ++row) {
+                if (!(std::abs(r2[row]) < 1e6)) {
+                    continue;
+                }
+                CHECK(std::abs(r1[row] - r2[row]) <= eps * (1 + std::abs(r1[row])));
+                for (size_t col = 0; col < cols; ++col) {
+                    auto a = j1[col * rows + row];
+                    auto b = j2[col * rows + row];
+                    if (std::abs(a) < 1e6) {
+                        CHECK(std::abs(a - b) <= eps * (1 + std::abs(a)));
+                    }
+                }
+            }
+        }
+    };
+
+    SUBCASE("arithmetic")
+    {
+        pset.SetConfig(PrimitiveSet::Arithmetic);
+        check(1e-10);
+    }
+
+    SUBCASE("arithmetic + unary functions")
+    {
+        pset.SetConfig(PrimitiveSet::Arithmetic | NodeType::Exp | NodeType::Log | NodeType::Sin | NodeType::Cos | NodeType::Tan | NodeType::Sqrt | NodeType::Cbrt | NodeType::Square);
+        check(1e-4);
+    }
+
+    SUBCASE("gathered rows")
+    {
+        // every third row of the range, the jacobian rows must match the corresponding rows of the range jacobian
+        std::vector<size_t> indices;
+        std::vector<Operon::Scalar> indexTarget;
+        for (size_t row = range.Start(); row < range.End(); row += 3) {
+            indices.push_back(row);
+            indexTarget.push_back(targetValues[row - range.Start()]);
+        }
+        pset.SetConfig(PrimitiveSet::Arithmetic | NodeType::Exp | NodeType::Log | NodeType::Sin | NodeType::Cos);
+        for (size_t i = 0; i < n; ++i) {
+            auto tree = creator(rd, sizeDistribution(rd), 0, maxDepth);
+            auto parameters = tree.GetCoefficients();
+
+            ReverseModeCostFunction<Eigen::ColMajor> whole(tree, ds, targetValues, range);
+            ReverseModeCostFunction<Eigen::ColMajor> gathered(tree, ds, indexTarget, gsl::span<size_t const>(indices));
+            REQUIRE(gathered.NumResiduals() == static_cast<int>(indices.size()));
+
+            auto rows = static_cast<size_t>(whole.NumResiduals());
+            auto cols = static_cast<size_t>(whole.NumParameters());
+            std::vector<Operon::Scalar> r1(rows), r2(indices.size()), j1(rows * cols), j2(indices.size() * cols);
+            REQUIRE(whole(parameters.data(), r1.data(), j1.data()));
+            REQUIRE(gathered(parameters.data(), r2.data(), j2.data()));
+
+            for (size_t k = 0; k < indices.size(); ++k) {
+                auto row = indices[k] - range.Start();
+                if (!std::isfinite(r1[row])) {
+                    continue;
+                }
+                CHECK(r2[k] == doctest::Approx(r1[row]));
+                for (size_t col = 0; col < cols; ++col) {
+                    auto a = j1[col * rows + row];
+                    if (std::isfinite(a)) {
+                        CHECK(j2[col * indices.size() + k] == doctest::Approx(a));
+                    }
+                }
+            }
+        }
+    }
+}
+} // namespace Operon::Test
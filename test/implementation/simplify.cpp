@@ -0,0 +1,139 @@
+/* This file is part of:
+ * Operon - Large Scale Genetic Programming Framework
+ *
+ * Licensed under the ISC License <https://opensource.org/licenses/ISC>
+ * Copyright (C) 2020 Bogdan Burlacu
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+ * REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+ * INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+ * LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+ * OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+ * PERFORMANCE OF THIS SOFTWARE.
+ */
+
+
+#include <doctest/doctest.h>
+
+#include "core/dataset.hpp"
+#include "core/eval.hpp"
+#include "core/pset.hpp"
+#include "operators/creator.hpp"
+
+namespace Operon::Test {
+TEST_CASE("Simplification")
+{
+    auto ds = Dataset("../data/Poly-10.csv", true);
+    Range range { 0, 250 };
+
+    auto x1 = Node(NodeType::Variable, ds.GetVariable("X1")->Hash);
+    auto x2 = Node(NodeType::Variable, ds.GetVariable("X2")->Hash);
+    auto constant = [](Operon::Scalar v) { auto c = Node(NodeType::Constant); c.Value = v; return c; };
+
+    auto add = Node(NodeType::Add);
+    auto sub = Node(NodeType::Sub);
+    auto mul = Node(NodeType::Mul);
+    auto div = Node(NodeType::Div);
+    auto exp = Node(NodeType::Exp);
+
+    auto simplify = [](std::initializer_list<Node> nodes) {
+        Tree tree(nodes);
+        tree.UpdateNodes();
+        return tree.Simplify();
+    };
+
+    SUBCASE("constant folding")
+    {
+        // exp(2 * 3) + 1
+        auto tree = simplify({ constant(1), constant(3), constant(2), mul, exp, add });
+        REQUIRE(tree.Length() == 1);
+        CHECK(tree[0].IsConstant());
+        CHECK(tree[0].Value == doctest::Approx(std::exp(6.0) + 1));
+    }
+
+    SUBCASE("identities and annihilators")
+    {
+        // (x1 + 0) * 1
+        auto tree = simplify({ constant(1), constant(0), x1, add, mul });
+        REQUIRE(tree.Length() == 1);
+        CHECK(tree[0].IsVariable());
+
+        // x2 * 0
+        tree = simplify({ constant(0), x2, mul });
+        REQUIRE(tree.Length() == 1);
+        CHECK(tree[0].IsConstant());
+        CHECK(tree[0].Value == 0);
+    }
+
+    SUBCASE("like terms")
+    {
+        // x1 - x1
+        auto tree = simplify({ x1, x1, sub });
+        REQUIRE(tree.Length() == 1);
+        CHECK(tree[0].IsConstant());
+        CHECK(tree[0].Value == 0);
+
+        // exp(x1) / exp(x1)
+        tree = simplify({ x1, exp, x1, exp, div });
+        REQUIRE(tree.Length() == 1);
+        CHECK(tree[0].Value == 1);
+
+        // (x1 + x2) + (2 * x1), the weighted variables are merged into 3 x1 + x2
+        tree = simplify({ x1, constant(2), mul, x2, x1, add, add });
+        REQUIRE(tree.Length() == 3);
+        CHECK(tree[2].IsAddition());
+        CHECK(tree[2].Arity == 2);
+    }
+
+    SUBCASE("n-ary flattening")
+    {
+        // ((x1 * exp(x2)) * x2) * exp(x1)
+        auto tree = simplify({ x1, exp, x2, x2, exp, x1, mul, mul, mul });
+        REQUIRE(tree.Length() == 7);
+        CHECK(tree[6].IsMultiplication());
+        CHECK(tree[6].Arity == 4);
+    }
+
+    SUBCASE("simplified trees evaluate to the same values")
+    {
+        size_t n = 1000;
+        size_t maxLength = 100;
+        size_t maxDepth = 1000;
+
+        Operon::RandomGenerator rd(1234);
+        auto variables = ds.Variables();
+        std::vector<Variable> inputs;
+        std::copy_if(variables.begin(), variables.end(), std::back_inserter(inputs), [&](const auto& v) { return v.Name != "Y"; });
+
+        PrimitiveSet pset;
+        pset.SetConfig(PrimitiveSet::Arithmetic | NodeType::Exp | NodeType::Log);
+        std::uniform_int_distribution<size_t> sizeDistribution(1, maxLength);
+        auto creator = BalancedTreeCreator { pset, inputs };
+
+        size_t totalLength { 0 }, simplifiedLength { 0 };
+        for (size_t i = 0; i < n; ++i) {
+            auto tree = creator(rd, sizeDistribution(rd), 0, maxDepth);
+            auto expected = Evaluate<Operon::Scalar>(tree, ds, range);
+            totalLength += tree.Length();
+
+            tree.Simplify();
+            auto actual = Evaluate<Operon::Scalar>(tree, ds, range);
+            simplifiedLength += tree.Length();
+
+            for (size_t j = 0; j < expected.size(); ++j) {
+                // the interpreter clamps non-finite values, which can differ after eg. annihilating 0 * log(0)
+                if (std::abs(expected[j]) < 1e3) {
+                    CHECK(actual[j] == doctest::Approx(expected[j]).epsilon(1e-3));
+                }
+            }
+        }
+        fmt::print("average length: {:.2f} -> {:.2f}\n", totalLength / static_cast<double>(n), simplifiedLength / static_cast<double>(n));
+        CHECK(simplifiedLength <= totalLength);
+    }
+}
+} // namespace Operon::Test
@@ -0,0 +1,107 @@
+/* This file is part of:
+ * Operon - Large Scale Genetic Programming Framework
+ *
+ * Licensed under the ISC License <https://opensource.org/licenses/ISC>
+ * Copyright (C) 2020 Bogdan Burlacu
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+ * REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+ * INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+ * LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+ * OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+ * PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include <doctest/doctest.h>
+
+#include "core/dataset.hpp"
+#include "core/eval.hpp"
+#include "core/pset.hpp"
+#include "core/subtree_cache.hpp"
+#include "operators/creator.hpp"
+
+namespace Operon::Test {
+TEST_CASE("Subtree cache")
+{
+    size_t n = 100;
+    size_t maxLength = 50;
+    size_t maxDepth = 1000;
+
+    Operon::RandomGenerator rd(1234);
+    auto ds = Dataset("../data/Poly-10.csv", true);
+
+    auto target = "Y";
+    auto variables = ds.Variables();
+    std::vector<Variable> inputs;
+    std::copy_if(variables.begin(), variables.end(), std::back_inserter(inputs), [&](const auto& v) { return v.Name != target; });
+
+    PrimitiveSet pset;
+    pset.SetConfig(PrimitiveSet::Arithmetic | NodeType::Exp | NodeType::Log);
+    std::uniform_int_distribution<size_t> sizeDistribution(1, maxLength);
+    auto creator = BalancedTreeCreator { pset, inputs };
+
+    std::vector<Tree> trees(n);
+    std::generate(trees.begin(), trees.end(), [&]() { return creator(rd, sizeDistribution(rd), 0, maxDepth); });
+
+    // offspring sharing whole branches with the trees above
+    std::uniform_int_distribution<size_t> pick(0, n - 1);
+    for (size_t i = 0; i < n; ++i) {
+        auto nodes = trees[pick(rd)].Nodes();
+        auto const& other = trees[pick(rd)].Nodes();
+        nodes.insert(nodes.end(), other.begin(), other.end());
+        nodes.emplace_back(i % 2 ? NodeType::Add : NodeType::Mul);
+        trees.push_back(Tree(nodes).UpdateNodes());
+    }
+
+    for (auto& tree : trees) {
+        tree.Hash<Operon::HashFunction::XXHash>(Operon::HashMode::Strict);
+    }
+
+    auto check = [&](SubtreeCache& cache, Range range) {
+        std::vector<Operon::Scalar> expected(range.Size());
+        std::vector<Operon::Scalar> actual(range.Size());
+        for (auto const& tree : trees) {
+            Evaluate(tree, ds, range, gsl::span<Operon::Scalar>(actual), cache);
+            Evaluate<Operon::Scalar>(tree, ds, range, gsl::span<Operon::Scalar>(expected));
+            CHECK(std::equal(actual.begin(), actual.end(), expected.begin(), [](auto a, auto b) { return a == b || (std::isnan(a) && std::isnan(b)); }));
+        }
+    };
+
+    SUBCASE("cached values match the interpreter")
+    {
+        SubtreeCache cache(1ul << 30);
+        check(cache, Range { 0, 250 });
+        check(cache, Range { 0, 250 });
+        CHECK(cache.Hits() > 0);
+        CHECK(cache.Evictions() == 0);
+    }
+
+    SUBCASE("memory budget")
+    {
+        Range range { 0, 250 };
+        size_t capacity = 10 * range.Size() * sizeof(Operon::Scalar);
+        SubtreeCache cache(capacity);
+        check(cache, range);
+        CHECK(cache.Size() <= 10);
+        CHECK(cache.MemoryUsage() <= capacity);
+        CHECK(cache.Evictions() > 0);
+    }
+
+    SUBCASE("range change")
+    {
+        SubtreeCache cache(1ul << 30);
+        check(cache, Range { 0, 250 });
+        auto size = cache.Size();
+        check(cache, Range { 250, 500 });
+        CHECK(cache.Size() <= size);
+        auto hits = cache.Hits();
+        check(cache, Range { 0, 250 });
+        CHECK(cache.Hits() >= hits);
+    }
+}
+} // namespace Operon::Test
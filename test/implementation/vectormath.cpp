@@ -0,0 +1,142 @@
+/* This file is part of:
+ * Operon - Large Scale Genetic Programming Framework
+ *
+ * Licensed under the ISC License <https://opensource.org/licenses/ISC>
+ * Copyright (C) 2020 Bogdan Burlacu
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+ * REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+ * INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+ * LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+ * OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+ * PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include <doctest/doctest.h>
+
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <random>
+#include <vector>
+
+#include "core/types.hpp"
+#include "core/vectormath.hpp"
+
+namespace Operon::Test {
+namespace {
+    // error in units in the last place of the (long double) reference value
+    template <typename T>
+    double Ulp(T value, long double reference)
+    {
+        if (std::isnan(reference)) {
+            return std::isnan(value) ? 0 : std::numeric_limits<double>::infinity();
+        }
+        if (std::isinf(reference) || std::abs(reference) > std::numeric_limits<T>::max()) {
+            return value == static_cast<T>(reference) ? 0 : std::numeric_limits<double>::infinity();
+        }
+        auto r = static_cast<T>(reference);
+        auto ulp = std::nextafter(std::abs(r), std::numeric_limits<T>::infinity()) - std::abs(r);
+        return static_cast<double>(std::abs(static_cast<long double>(value) - reference) / ulp);
+    }
+
+    template <typename T, typename F, typename G>
+    double MaxError(std::vector<T> const& x, F&& f, G&& reference)
+    {
+        std::vector<T> y(x.size());
+        f(x.data(), y.data(), x.size());
+        double err { 0 };
+        for (size_t i = 0; i < x.size(); ++i) {
+            err = std::max(err, Ulp(y[i], reference(static_cast<long double>(x[i]))));
+        }
+        return err;
+    }
+
+    // random values with uniformly distributed bit patterns (covering all the magnitudes, including subnormals)
+    template <typename T>
+    std::vector<T> Bits(Operon::RandomGenerator& rng, size_t n, bool positive)
+    {
+        using U = std::conditional_t<sizeof(T) == 8, uint64_t, uint32_t>;
+        auto const maxBits = [] { T m = std::numeric_limits<T>::max(); U u; std::memcpy(&u, &m, sizeof(T)); return u; }();
+        std::uniform_int_distribution<U> dist(0, maxBits);
+        std::vector<T> x(n);
+        for (auto& v : x) {
+            U u = dist(rng);
+            std::memcpy(&v, &u, sizeof(T));
+            if (!positive && std::bernoulli_distribution(0.5)(rng)) {
+                v = -v;
+            }
+        }
+        return x;
+    }
+
+    template <typename T>
+    std::vector<T> Uniform(Operon::RandomGenerator& rng, size_t n, T a, T b)
+    {
+        std::uniform_real_distribution<T> dist(a, b);
+        std::vector<T> x(n);
+        for (auto& v : x) {
+            v = dist(rng);
+        }
+        return x;
+    }
+
+    template <typename T>
+    void CheckAccuracy(Operon::RandomGenerator& rng)
+    {
+        constexpr size_t n = 100'003; // not a multiple of the vector width
+        constexpr T trigMax = T(0x1p19);
+        auto inf = std::numeric_limits<T>::infinity();
+        auto nan = std::numeric_limits<T>::quiet_NaN();
+        auto specials = std::vector<T> { T(0), -T(0), T(1), -T(1), inf, -inf, nan, std::numeric_limits<T>::min(), std::numeric_limits<T>::denorm_min(), std::numeric_limits<T>::max() };
+
+        auto with = [&](std::vector<T> x) { x.insert(x.end(), specials.begin(), specials.end()); return x; };
+
+        auto exp = [](T const* x, T* y, size_t k) { VectorMath::Exp(x, y, k); };
+        auto log = [](T const* x, T* y, size_t k) { VectorMath::Log(x, y, k); };
+        auto sin = [](T const* x, T* y, size_t k) { VectorMath::Sin(x, y, k); };
+        auto cos = [](T const* x, T* y, size_t k) { VectorMath::Cos(x, y, k); };
+        auto tan = [](T const* x, T* y, size_t k) { VectorMath::Tan(x, y, k); };
+        auto cbrt = [](T const* x, T* y, size_t k) { VectorMath::Cbrt(x, y, k); };
+
+        auto lo = std::log(std::numeric_limits<T>::denorm_min()) - 1;
+        auto hi = std::log(std::numeric_limits<T>::max()) + 1;
+
+        CHECK(MaxError(with(Uniform<T>(rng, n, lo, hi)), exp, [](long double v) { return std::exp(v); }) <= 1);
+        CHECK(MaxError(with(Uniform<T>(rng, n, -1, 1)), exp, [](long double v) { return std::exp(v); }) <= 1);
+        CHECK(MaxError(with(Bits<T>(rng, n, false)), log, [](long double v) { return std::log(v); }) <= 1);
+        CHECK(MaxError(with(Uniform<T>(rng, n, T(0.5), T(2))), log, [](long double v) { return std::log(v); }) <= 1);
+        CHECK(MaxError(with(Bits<T>(rng, n, false)), cbrt, [](long double v) { return std::cbrt(v); }) <= 1);
+
+        for (auto r : { T(1), T(99), trigMax, 2 * trigMax }) {
+            auto x = with(Uniform<T>(rng, n, -r, r));
+            auto bound = r < 100 ? 1.5 : 2.5;
+            CHECK(MaxError(x, sin, [](long double v) { return std::sin(v); }) <= bound);
+            CHECK(MaxError(x, cos, [](long double v) { return std::cos(v); }) <= bound);
+            CHECK(MaxError(x, tan, [](long double v) { return std::tan(v); }) <= 3.5);
+        }
+    }
+} // namespace
+
+TEST_CASE("Vectorized math functions")
+{
+    Operon::RandomGenerator rng(1234);
+    auto supported = VectorMath::Supported();
+
+    // the scalar fallback calls the standard library, only the vectorized implementations are checked against the documented bounds
+    for (auto set : { VectorMath::InstructionSet::AVX2, VectorMath::InstructionSet::AVX512 }) {
+        if (static_cast<int>(set) > static_cast<int>(supported)) {
+            continue;
+        }
+        VectorMath::Select(set);
+        CheckAccuracy<float>(rng);
+        CheckAccuracy<double>(rng);
+    }
+    VectorMath::Select(supported);
+}
+} // namespace Operon::Test
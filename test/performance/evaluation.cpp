@@ -183,6 +183,160 @@ namespace Test {
             }
         }
     }
+
+    // compares the evaluation buffer layouts (one scratch column per node vs. reused scratch columns)
+    // the benefit of column reuse should increase with the tree length, as the buffer no longer fits in cache
+    TEST_CASE("Evaluation performance vs tree length")
+    {
+        size_t n = 100;
+        size_t maxDepth = 1000;
+
+        Operon::RandomGenerator rd(1234);
+        auto ds = Dataset("../data/Friedman-I.csv", true);
+
+        auto target = "Y";
+        auto variables = ds.Variables();
+        std::vector<Variable> inputs;
+        std::copy_if(variables.begin(), variables.end(), std::back_inserter(inputs), [&](const auto& v) { return v.Name != target; });
+
+        Range range = { 0, 5000 };
+
+        PrimitiveSet pset;
+        pset.SetConfig(PrimitiveSet::Arithmetic);
+        for (auto t : { NodeType::Add, NodeType::Sub, NodeType::Div, NodeType::Mul }) {
+            pset.SetMinMaxArity(t, 2, 2);
+        }
+        auto creator = BalancedTreeCreator { pset, inputs };
+
+        std::vector<Tree> trees(n);
+        std::vector<Tape> tapes(n);
+        std::vector<Operon::Scalar> result(range.Size());
+
+        nb::Bench b;
+        b.title("tree length").relative(true).performanceCounters(true).minEpochIterations(5);
+
+        for (size_t length : { 10, 25, 50, 100, 200, 500, 1000 }) {
+            std::generate(trees.begin(), trees.end(), [&]() { return creator(rd, length, 0, maxDepth); });
+            auto totalOps = TotalNodes(trees) * range.Size();
+
+            for (auto reuse : { false, true }) {
+                std::transform(trees.begin(), trees.end(), tapes.begin(), [&](auto const& tree) { return Tape(tree, ds, reuse); });
+                b.batch(totalOps);
+                b.run(fmt::format("length {} {}", length, reuse ? "reused columns" : "column per node"), [&]() {
+                    for (auto const& tape : tapes) {
+                        Evaluate<Operon::Scalar>(tape, range, gsl::span<Operon::Scalar>(result));
+                    }
+                });
+            }
+        }
+    }
+
+    // evaluation speed (GPops/s) of each precompiled batch size (see BatchSizes) for increasing tree lengths, used to validate
+    // the heuristic of AutomaticBatchSize on a given machine (reported as "automatic")
+    TEST_CASE("Evaluation performance vs batch size")
+    {
+        size_t n = 100;
+        size_t maxDepth = 1000;
+
+        Operon::RandomGenerator rd(1234);
+        auto ds = Dataset("../data/Friedman-I.csv", true);
+
+        auto target = "Y";
+        auto variables = ds.Variables();
+        std::vector<Variable> inputs;
+        std::copy_if(variables.begin(), variables.end(), std::back_inserter(inputs), [&](const auto& v) { return v.Name != target; });
+
+        Range range = { 0, 5000 };
+
+        PrimitiveSet pset;
+        pset.SetConfig(PrimitiveSet::Arithmetic | NodeType::Exp | NodeType::Log);
+        for (auto t : { NodeType::Add, NodeType::Sub, NodeType::Div, NodeType::Mul }) {
+            pset.SetMinMaxArity(t, 2, 2);
+        }
+        auto creator = BalancedTreeCreator { pset, inputs };
+
+        std::vector<Tree> trees(n);
+        std::vector<Tape> tapes(n);
+        std::vector<Operon::Scalar> result(range.Size());
+
+        nb::Bench b;
+        b.title("batch size").relative(true).performanceCounters(true).minEpochIterations(5);
+
+        for (size_t length : { 10, 25, 50, 100, 200, 500, 1000 }) {
+            std::generate(trees.begin(), trees.end(), [&]() { return creator(rd, length, 0, maxDepth); });
+            std::transform(trees.begin(), trees.end(), tapes.begin(), [&](auto const& tree) { return Tape(tree, ds); });
+            auto totalOps = TotalNodes(trees) * range.Size();
+
+            auto run = [&](std::string const& name, size_t batchSize) {
+                b.batch(totalOps);
+                b.run(fmt::format("length {} {}", length, name), [&]() {
+                    for (auto const& tape : tapes) {
+                        WithBatchSize<Operon::Scalar>(batchSize, tape.Columns(), [&](auto s) {
+                            constexpr size_t S = decltype(s)::value;
+                            Evaluate<Operon::Scalar, S>(tape, range, gsl::span<Operon::Scalar>(result), nullptr, EvaluationContext<Operon::Scalar, S>::Default());
+                        });
+                    }
+                });
+            };
+            for (auto batchSize : BatchSizes<Operon::Scalar>) {
+                run(fmt::format("S = {}", batchSize), batchSize);
+            }
+            run("automatic", 0);
+        }
+    }
+
+    // compares tree-by-tree evaluation with population-batched evaluation (row tiles in the outer loop, trees in the inner loop)
+    TEST_CASE("Population evaluation performance")
+    {
+        size_t n = 1000;
+        size_t maxLength = 100;
+        size_t maxDepth = 1000;
+        size_t groupSize = 32;
+
+        Operon::RandomGenerator rd(1234);
+        auto ds = Dataset("../data/Friedman-I.csv", true);
+
+        auto target = "Y";
+        auto variables = ds.Variables();
+        std::vector<Variable> inputs;
+        std::copy_if(variables.begin(), variables.end(), std::back_inserter(inputs), [&](const auto& v) { return v.Name != target; });
+
+        Range range = { 0, ds.Rows() };
+
+        PrimitiveSet pset;
+        pset.SetConfig(PrimitiveSet::Arithmetic);
+        for (auto t : { NodeType::Add, NodeType::Sub, NodeType::Div, NodeType::Mul }) {
+            pset.SetMinMaxArity(t, 2, 2);
+        }
+        std::uniform_int_distribution<size_t> sizeDistribution(1, maxLength);
+        auto creator = BalancedTreeCreator { pset, inputs };
+
+        std::vector<Tree> trees(n);
+        std::generate(trees.begin(), trees.end(), [&]() { return creator(rd, sizeDistribution(rd), 0, maxDepth); });
+        std::vector<Tape> tapes;
+        std::transform(trees.begin(), trees.end(), std::back_inserter(tapes), [&](auto const& tree) { return Tape(tree, ds); });
+
+        std::vector<Operon::Scalar> result(groupSize * range.Size());
+        auto totalOps = TotalNodes(trees) * range.Size();
+
+        nb::Bench b;
+        b.title("population evaluation").relative(true).performanceCounters(true).minEpochIterations(5);
+        b.batch(totalOps);
+
+        b.run("tree by tree", [&]() {
+            for (auto const& tape : tapes) {
+                Evaluate<Operon::Scalar>(tape, range, gsl::span<Operon::Scalar>(result).subspan(0, range.Size()));
+            }
+        });
+
+        for (size_t tileSize : { 256, 1024, 4096 }) {
+            b.run(fmt::format("population (tile size {})", tileSize), [&]() {
+                for (size_t i = 0; i < tapes.size(); i += groupSize) {
+                    auto group = gsl::span<Tape const>(tapes).subspan(i, std::min(groupSize, tapes.size() - i));
+                    EvaluatePopulation<Operon::Scalar>(group, range, gsl::span<Operon::Scalar>(result), tileSize);
+                }
+            });
+        }
+    }
 } // namespace Test
 } // namespace Operon
-
@@ -6,6 +6,7 @@
 
 #include "core/types.hpp"
 #include "core/common.hpp"
+#include "core/vectormath.hpp"
 
 #include <Eigen/Core>
 
@@ -67,4 +68,46 @@ TEST_CASE("Libm functions cost model")
     }
 }
 
+TEST_CASE("Vectorized math functions")
+{
+    Operon::RandomGenerator rand(1234);
+    // the size of a batch evaluated by the interpreter
+    constexpr int rows = 64;
+    using VectorMath::InstructionSet;
+
+    auto bench = [&](auto type, std::string const& title) {
+        using T = decltype(type);
+        Eigen::Array<T, Eigen::Dynamic, 1> x(rows), y(rows);
+        // arguments within the domain of all the functions, and well within the range handled by the vectorized sin/cos/tan
+        std::uniform_real_distribution<T> dist(T(0.01), T(10));
+        for (auto& v : x) { v = dist(rand); }
+
+        nb::Bench b;
+        b.title(title).relative(true).performanceCounters(true).minEpochIterations(100000);
+
+        auto run = [&](std::string const& name, auto&& eigen, auto&& vectorized) {
+            b.run(name + " eigen", [&]() { y = eigen(x); nb::doNotOptimizeAway(y); });
+            for (auto set : { InstructionSet::Scalar, InstructionSet::AVX2, InstructionSet::AVX512 }) {
+                if (static_cast<int>(set) > static_cast<int>(VectorMath::Supported())) {
+                    continue;
+                }
+                VectorMath::Select(set);
+                auto isa = set == InstructionSet::Scalar ? "scalar" : (set == InstructionSet::AVX2 ? "avx2" : "avx512");
+                b.run(name + " " + isa, [&]() { vectorized(x.data(), y.data(), rows); nb::doNotOptimizeAway(y); });
+            }
+            VectorMath::Select(VectorMath::Supported());
+        };
+
+        run("exp", [](auto const& a) { return a.exp(); }, [](T const* a, T* r, size_t n) { VectorMath::Exp(a, r, n); });
+        run("log", [](auto const& a) { return a.log(); }, [](T const* a, T* r, size_t n) { VectorMath::Log(a, r, n); });
+        run("sin", [](auto const& a) { return a.sin(); }, [](T const* a, T* r, size_t n) { VectorMath::Sin(a, r, n); });
+        run("cos", [](auto const& a) { return a.cos(); }, [](T const* a, T* r, size_t n) { VectorMath::Cos(a, r, n); });
+        run("tan", [](auto const& a) { return a.tan(); }, [](T const* a, T* r, size_t n) { VectorMath::Tan(a, r, n); });
+        run("cbrt", [](auto const& a) { return a.unaryExpr([](T v) { return std::cbrt(v); }); }, [](T const* a, T* r, size_t n) { VectorMath::Cbrt(a, r, n); });
+    };
+
+    SUBCASE("double-precision") { bench(double {}, "double-precision"); }
+    SUBCASE("single-precision") { bench(float {}, "single-precision"); }
+}
+
 }
@@ -0,0 +1,120 @@
+/* This file is part of:
+ * Operon - Large Scale Genetic Programming Framework
+ *
+ * Licensed under the ISC License <https://opensource.org/licenses/ISC>
+ * Copyright (C) 2020 Bogdan Burlacu
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+ * REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+ * INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+ * LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+ * OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+ * PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include <doctest/doctest.h>
+
+#include "core/dataset.hpp"
+#include "core/eval.hpp"
+#include "core/pset.hpp"
+#include "nnls/tiny_optimizer.hpp"
+#include "operators/creator.hpp"
+
+#include "nanobench.h"
+
+namespace Operon {
+namespace Test {
+    namespace nb = ankerl::nanobench;
+
+    // one Levenberg-Marquardt iteration is dominated by the computation of the residuals and the jacobian,
+    // forward-mode autodiff needs ceil(numParameters / Dual::DIMENSION) passes while reverse-mode needs one forward and one backward pass
+    TEST_CASE("Jacobian performance")
+    {
+        size_t n = 100;
+        size_t maxDepth = 1000;
+
+        Operon::RandomGenerator rd(1234);
+        auto ds = Dataset("../data/Poly-10.csv", true);
+
+        auto target = "Y";
+        auto variables = ds.Variables();
+        std::vector<Variable> inputs;
+        std::copy_if(variables.begin(), variables.end(), std::back_inserter(inputs), [&](const auto& v) { return v.Name != target; });
+
+        Range range = { 0, ds.Rows() };
+        auto targetValues = ds.GetValues(target).subspan(range.Start(), range.Size());
+
+        PrimitiveSet pset;
+        pset.SetConfig(PrimitiveSet::Arithmetic);
+        for (auto t : { NodeType::Add, NodeType::Sub, NodeType::Div, NodeType::Mul }) {
+            pset.SetMinMaxArity(t, 2, 2);
+        }
+        auto creator = BalancedTreeCreator { pset, inputs };
+
+        std::vector<Tree> trees(n);
+        std::vector<Operon::Scalar> residuals(range.Size());
+        std::vector<Operon::Scalar> jacobian;
+
+        SUBCASE("residuals and jacobian")
+        {
+            nb::Bench b;
+            b.title("jacobian").unit("iteration").relative(true).performanceCounters(true).minEpochIterations(5);
+
+            for (size_t length : { 10, 25, 50, 100 }) {
+                std::generate(trees.begin(), trees.end(), [&]() { return creator(rd, length, 0, maxDepth); });
+                b.batch(trees.size());
+
+                b.run(fmt::format("length {} forward (jet)", length), [&]() {
+                    for (auto const& tree : trees) {
+                        TinyCostFunction<ResidualEvaluator, Dual, Eigen::ColMajor> cf(tree, ds, targetValues, range);
+                        auto parameters = tree.GetCoefficients();
+                        jacobian.resize(static_cast<size_t>(cf.NumResiduals() * cf.NumParameters()));
+                        cf(parameters.data(), residuals.data(), jacobian.data());
+                    }
+                });
+
+                b.run(fmt::format("length {} reverse", length), [&]() {
+                    for (auto const& tree : trees) {
+                        ReverseModeCostFunction<Eigen::ColMajor> cf(tree, ds, targetValues, range);
+                        auto parameters = tree.GetCoefficients();
+                        jacobian.resize(static_cast<size_t>(cf.NumResiduals() * cf.NumParameters()));
+                        cf(parameters.data(), residuals.data(), jacobian.data());
+                    }
+                });
+            }
+        }
+
+        SUBCASE("local optimization")
+        {
+            size_t iterations = 10;
+
+            nb::Bench b;
+            b.title("optimizer").unit("iteration").relative(true).performanceCounters(true).minEpochIterations(5);
+
+            for (size_t length : { 10, 25, 50, 100 }) {
+                std::generate(trees.begin(), trees.end(), [&]() { return creator(rd, length, 0, maxDepth); });
+                b.batch(trees.size() * iterations);
+
+                b.run(fmt::format("length {} forward (jet)", length), [&]() {
+                    Optimizer<DerivativeMethod::AUTODIFF, OptimizerType::TINY> optimizer;
+                    for (auto tree : trees) {
+                        optimizer.Optimize(tree, ds, targetValues, range, iterations);
+                    }
+                });
+
+                b.run(fmt::format("length {} reverse", length), [&]() {
+                    Optimizer<DerivativeMethod::REVERSE, OptimizerType::TINY> optimizer;
+                    for (auto tree : trees) {
+                        optimizer.Optimize(tree, ds, targetValues, range, iterations);
+                    }
+                });
+            }
+        }
+    }
+} // namespace Test
+} // namespace Operon